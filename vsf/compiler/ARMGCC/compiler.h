@@ -28,4 +28,17 @@ char* strdup(const char *source);
 #define PACKED_MID	__attribute__ ((packed))
 #define PACKED_TAIL	
 
+// atomic operations, used by lock-free structures
+// vsf_atomic_add returns the new value
+// vsf_atomic_cas returns true if *ptr equals oldv and is replaced by newv
+#define vsf_atomic_add(ptr, value)		\
+	__atomic_add_fetch((ptr), (value), __ATOMIC_SEQ_CST)
+#define vsf_atomic_cas(ptr, oldv, newv)	\
+	({\
+		uint32_t __expected = (oldv);\
+		__atomic_compare_exchange_n((ptr), &__expected, (newv), false,\
+							__ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);\
+	})
+#define vsf_barrier()					__atomic_thread_fence(__ATOMIC_SEQ_CST)
+
 #endif	// __COMPILER_H_INCLUDED__
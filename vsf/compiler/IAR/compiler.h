@@ -2,6 +2,8 @@
 #define __COMPILER_H_INCLUDED__
 
 #include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include <intrinsics.h>
 
 #define __VSF_FUNCNAME__				"cur_function"
@@ -14,4 +16,34 @@
 #define vsf_enter_critical()			__disable_interrupt()
 #define vsf_leave_critical()			__enable_interrupt()
 
+// atomic operations, used by lock-free structures
+// implemented by LDREX/STREX, so only available on Cortex-M3 and above
+// vsf_atomic_add returns the new value
+// vsf_atomic_cas returns true if *ptr equals oldv and is replaced by newv
+static inline uint32_t vsf_atomic_add(volatile uint32_t *ptr, uint32_t value)
+{
+	uint32_t result;
+	do
+	{
+		result = __LDREX((unsigned long *)ptr) + value;
+	} while (__STREX(result, (unsigned long *)ptr));
+	__DMB();
+	return result;
+}
+static inline bool vsf_atomic_cas(volatile uint32_t *ptr, uint32_t oldv,
+									uint32_t newv)
+{
+	do
+	{
+		if (__LDREX((unsigned long *)ptr) != oldv)
+		{
+			__CLREX();
+			return false;
+		}
+	} while (__STREX(newv, (unsigned long *)ptr));
+	__DMB();
+	return true;
+}
+#define vsf_barrier()					__DMB()
+
 #endif	// __COMPILER_H_INCLUDED__
@@ -21,6 +21,7 @@
 #define __COMPILER_H_INCLUDED__
 
 #include <string.h>
+#include <intrin.h>
 
 #define __VSF_FUNCNAME__				__FUNCTION__
 
@@ -29,4 +30,15 @@
 #define PACKED_MID	
 #define PACKED_TAIL	#pragma pack(pop)
 
+// atomic operations, used by lock-free structures
+// vsf_atomic_add returns the new value
+// vsf_atomic_cas returns true if *ptr equals oldv and is replaced by newv
+#define vsf_atomic_add(ptr, value)		\
+	((uint32_t)_InterlockedExchangeAdd((volatile long *)(ptr), (long)(value))\
+		+ (value))
+#define vsf_atomic_cas(ptr, oldv, newv)	\
+	((uint32_t)_InterlockedCompareExchange((volatile long *)(ptr),\
+		(long)(newv), (long)(oldv)) == (oldv))
+#define vsf_barrier()					_ReadWriteBarrier()
+
 #endif	// __COMPILER_H_INCLUDED__
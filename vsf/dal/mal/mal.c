@@ -532,58 +532,127 @@ static vsf_err_t mal_eraseall(struct dal_info_t *info)
 	}
 }
 
-static vsf_err_t mal_readblock(struct dal_info_t *info, 
-								uint64_t address, uint8_t *buff, uint64_t count)
+static vsf_err_t mal_check_list(struct vsf_buffer_list_t *list,
+									uint32_t page_size, uint64_t *count)
+{
+	*count = 0;
+	if (!page_size || (NULL == list))
+	{
+		return VSFERR_FAIL;
+	}
+	for (; list != NULL; list = list->next)
+	{
+		if (list->buffer.size % page_size)
+		{
+			return VSFERR_INVALID_PARAMETER;
+		}
+		*count += list->buffer.size / page_size;
+	}
+	return VSFERR_NONE;
+}
+
+static vsf_err_t mal_readblock_list(struct dal_info_t *info, 
+						uint64_t address, struct vsf_buffer_list_t *list)
 {
 	struct mal_info_t *mal_info = (struct mal_info_t *)info->extra;
-	uint64_t i;
+	uint32_t page_size = mal_info->read_page_size;
+	uint64_t count;
+	uint8_t *buff;
+	uint32_t i;
 	
-	if (!mal_info->read_page_size || 
-		mal_readblock_nb_start(info, address, count, buff))
+	if (mal_check_list(list, page_size, &count) || 
+		mal_readblock_nb_start(info, address, count, list->buffer.buffer))
 	{
 		return VSFERR_FAIL;
 	}
 	
-	for (i = 0; i < count; i++)
+	for (; list != NULL; list = list->next)
 	{
-		if (mal_readblock_waitready(info, address, buff) || 
-			mal_readblock_nb(info, address, buff))
+		buff = list->buffer.buffer;
+		for (i = 0; i < list->buffer.size / page_size; i++)
 		{
-			return VSFERR_FAIL;
+			if (mal_readblock_waitready(info, address, buff) || 
+				mal_readblock_nb(info, address, buff))
+			{
+				return VSFERR_FAIL;
+			}
+			address += page_size;
+			buff += page_size;
 		}
-		address += mal_info->read_page_size;
-		buff += mal_info->read_page_size;
 	}
 	
 	return mal_readblock_nb_end(info);
 }
 
-static vsf_err_t mal_writeblock(struct dal_info_t *info, 
-								uint64_t address, uint8_t *buff, uint64_t count)
+static vsf_err_t mal_writeblock_list(struct dal_info_t *info, 
+						uint64_t address, struct vsf_buffer_list_t *list)
 {
 	struct mal_info_t *mal_info = (struct mal_info_t *)info->extra;
-	uint64_t i;
+	uint32_t page_size = mal_info->write_page_size;
+	uint64_t count;
+	uint8_t *buff;
+	uint32_t i;
 	
-	if (!mal_info->write_page_size || 
-		mal_writeblock_nb_start(info, address, count, buff))
+	if (mal_check_list(list, page_size, &count) || 
+		mal_writeblock_nb_start(info, address, count, list->buffer.buffer))
 	{
 		return VSFERR_FAIL;
 	}
 	
-	for (i = 0; i < count; i++)
+	for (; list != NULL; list = list->next)
 	{
-		if (mal_writeblock_nb(info, address, buff) || 
-			mal_writeblock_waitready(info, address, buff))
+		buff = list->buffer.buffer;
+		for (i = 0; i < list->buffer.size / page_size; i++)
 		{
-			return VSFERR_FAIL;
+			if (mal_writeblock_nb(info, address, buff) || 
+				mal_writeblock_waitready(info, address, buff))
+			{
+				return VSFERR_FAIL;
+			}
+			address += page_size;
+			buff += page_size;
 		}
-		address += mal_info->write_page_size;
-		buff += mal_info->write_page_size;
 	}
 	
 	return mal_writeblock_nb_end(info);
 }
 
+static vsf_err_t mal_readblock(struct dal_info_t *info, 
+								uint64_t address, uint8_t *buff, uint64_t count)
+{
+	struct mal_info_t *mal_info = (struct mal_info_t *)info->extra;
+	uint32_t page_size = mal_info->read_page_size;
+	struct vsf_buffer_list_t list;
+	
+	// size of one segment is 32-bit, reject instead of truncating
+	if (!page_size || (count > 0xFFFFFFFFUL / page_size))
+	{
+		return VSFERR_INVALID_PARAMETER;
+	}
+	list.buffer.buffer = buff;
+	list.buffer.size = (uint32_t)count * page_size;
+	list.next = NULL;
+	return mal_readblock_list(info, address, &list);
+}
+
+static vsf_err_t mal_writeblock(struct dal_info_t *info, 
+								uint64_t address, uint8_t *buff, uint64_t count)
+{
+	struct mal_info_t *mal_info = (struct mal_info_t *)info->extra;
+	uint32_t page_size = mal_info->write_page_size;
+	struct vsf_buffer_list_t list;
+	
+	// size of one segment is 32-bit, reject instead of truncating
+	if (!page_size || (count > 0xFFFFFFFFUL / page_size))
+	{
+		return VSFERR_INVALID_PARAMETER;
+	}
+	list.buffer.buffer = buff;
+	list.buffer.size = (uint32_t)count * page_size;
+	list.next = NULL;
+	return mal_writeblock_list(info, address, &list);
+}
+
 const struct mal_t mal = 
 {
 	mal_init,
@@ -595,6 +664,8 @@ const struct mal_t mal =
 	mal_eraseblock,
 	mal_readblock,
 	mal_writeblock,
+	mal_readblock_list,
+	mal_writeblock_list,
 	
 	mal_init_nb,
 	mal_init_nb_isready,
@@ -21,6 +21,7 @@
 #define __MAL_H_INCLUDED__
 
 #include "app_type.h"
+#include "tool/buffer/buffer.h"
 
 #include "../dal.h"
 
@@ -55,6 +56,11 @@ struct mal_t
 						uint64_t address, uint8_t *buff, uint64_t count);
 	vsf_err_t (*writeblock)(struct dal_info_t *param, 
 							uint64_t address, uint8_t *buff, uint64_t count);
+	// size of every segment in list MUST be multiple of read/write page size
+	vsf_err_t (*readblock_list)(struct dal_info_t *param, 
+							uint64_t address, struct vsf_buffer_list_t *list);
+	vsf_err_t (*writeblock_list)(struct dal_info_t *param, 
+							uint64_t address, struct vsf_buffer_list_t *list);
 	
 	vsf_err_t (*init_nb)(struct dal_info_t *param);
 	vsf_err_t (*init_nb_isready)(struct dal_info_t *param);
@@ -0,0 +1,354 @@
+/***************************************************************************
+ *   Copyright (C) 2009 - 2010 by Simon Qian <SimonQian@SimonQian.com>     *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "app_cfg.h"
+#include "app_type.h"
+#include "compiler.h"
+
+#include "mal.h"
+
+#if DAL_MAL_EN
+
+#include "mal_async.h"
+
+enum mal_async_evt_t
+{
+	MAL_ASYNC_EVT_SUBMIT = VSFSM_EVT_USER_LOCAL + 0,
+	MAL_ASYNC_EVT_POLL = VSFSM_EVT_USER_LOCAL + 1,
+};
+
+enum mal_async_state_t
+{
+	MAL_ASYNC_STATE_START,
+	MAL_ASYNC_STATE_XFER,
+	MAL_ASYNC_STATE_WAIT,
+	MAL_ASYNC_STATE_END,
+	MAL_ASYNC_STATE_DONE,
+};
+
+static vsf_err_t mal_async_isready(struct dal_info_t *info,
+			struct mal_async_req_t *req, uint64_t address, uint8_t *buff)
+{
+	vsf_err_t err;
+	
+	// driver without _nb_isready can only be waited for
+	switch (req->op)
+	{
+	case MAL_ASYNC_OP_READ:
+		err = mal.readblock_nb_isready(info, address, buff);
+		if (VSFERR_NOT_SUPPORT == err)
+		{
+			err = mal.readblock_waitready(info, address, buff);
+		}
+		break;
+	case MAL_ASYNC_OP_WRITE:
+		err = mal.writeblock_nb_isready(info, address, buff);
+		if (VSFERR_NOT_SUPPORT == err)
+		{
+			err = mal.writeblock_waitready(info, address, buff);
+		}
+		break;
+	default:
+		err = mal.eraseblock_nb_isready(info, address);
+		if (VSFERR_NOT_SUPPORT == err)
+		{
+			err = mal.eraseblock_waitready(info, address);
+		}
+		break;
+	}
+	return err;
+}
+
+// return VSFERR_NOT_READY if device is busy, VSFERR_NONE if one page is
+// 		processed or the request is done
+static vsf_err_t mal_async_run(struct mal_async_t *mal_async,
+								struct mal_async_req_t *req)
+{
+	struct dal_info_t *info = mal_async->info;
+	struct mal_info_t *mal_info = (struct mal_info_t *)info->extra;
+	uint32_t page_size;
+	uint64_t address;
+	uint8_t *buff = NULL;
+	vsf_err_t err;
+	
+	switch (req->op)
+	{
+	case MAL_ASYNC_OP_READ:
+		page_size = mal_info->read_page_size;
+		break;
+	case MAL_ASYNC_OP_WRITE:
+		page_size = mal_info->write_page_size;
+		break;
+	case MAL_ASYNC_OP_ERASE:
+		page_size = mal_info->erase_page_size;
+		break;
+	default:
+		return VSFERR_INVALID_PARAMETER;
+	}
+	
+	while (1)
+	{
+		address = req->address + req->cur * page_size;
+		if (req->buff != NULL)
+		{
+			buff = req->buff + req->cur * page_size;
+		}
+		
+		switch (req->state)
+		{
+		case MAL_ASYNC_STATE_START:
+			if (!page_size || !req->count)
+			{
+				return VSFERR_INVALID_PARAMETER;
+			}
+			if (MAL_ASYNC_OP_READ == req->op)
+			{
+				// wait for the first page before reading it
+				err = mal.readblock_nb_start(info, address, req->count, buff);
+				req->state = MAL_ASYNC_STATE_WAIT;
+			}
+			else
+			{
+				err = (MAL_ASYNC_OP_WRITE == req->op) ?
+					mal.writeblock_nb_start(info, address, req->count, buff) :
+					mal.eraseblock_nb_start(info, address, req->count);
+				req->state = MAL_ASYNC_STATE_XFER;
+			}
+			if (err)
+			{
+				return err;
+			}
+			break;
+		case MAL_ASYNC_STATE_XFER:
+			switch (req->op)
+			{
+			case MAL_ASYNC_OP_READ:
+				err = mal.readblock_nb(info, address, buff);
+				if (err)
+				{
+					return err;
+				}
+				req->cur++;
+				req->state = (req->cur < req->count) ?
+							MAL_ASYNC_STATE_WAIT : MAL_ASYNC_STATE_END;
+				// yield after every page
+				return VSFERR_NONE;
+			case MAL_ASYNC_OP_WRITE:
+				err = mal.writeblock_nb(info, address, buff);
+				break;
+			default:
+				err = mal.eraseblock_nb(info, address);
+				break;
+			}
+			if (err)
+			{
+				return err;
+			}
+			req->state = MAL_ASYNC_STATE_WAIT;
+			break;
+		case MAL_ASYNC_STATE_WAIT:
+			err = mal_async_isready(info, req, address, buff);
+			if (err)
+			{
+				return err;
+			}
+			if (MAL_ASYNC_OP_READ == req->op)
+			{
+				req->state = MAL_ASYNC_STATE_XFER;
+				break;
+			}
+			req->cur++;
+			req->state = (req->cur < req->count) ?
+							MAL_ASYNC_STATE_XFER : MAL_ASYNC_STATE_END;
+			return VSFERR_NONE;
+		case MAL_ASYNC_STATE_END:
+			req->state = MAL_ASYNC_STATE_DONE;
+			switch (req->op)
+			{
+			case MAL_ASYNC_OP_READ:
+				return mal.readblock_nb_end(info);
+			case MAL_ASYNC_OP_WRITE:
+				return mal.writeblock_nb_end(info);
+			default:
+				return mal.eraseblock_nb_end(info);
+			}
+		default:
+			return VSFERR_BUG;
+		}
+	}
+}
+
+// poll after interval ms, or in the next round of vsfsm_poll if 0
+static void mal_async_repoll(struct mal_async_t *mal_async, uint32_t interval)
+{
+	// the timer is the only one pending poll of the sm, so it is also used
+	// 		if the event queue is full, otherwise the request will hang
+	if (interval ||
+		vsfsm_post_evt_pending(&mal_async->sm, MAL_ASYNC_EVT_POLL))
+	{
+		mal_async->timer.interval = interval ? interval : 1;
+		vsftimer_register(&mal_async->timer);
+	}
+}
+
+static void mal_async_poll(struct mal_async_t *mal_async)
+{
+	struct mal_async_req_t *req;
+	struct vsf_dlist_node_t *node;
+	vsf_err_t err;
+	
+	while (1)
+	{
+		req = mal_async->cur;
+		if (NULL == req)
+		{
+			vsf_enter_critical();
+			node = mal_async->queue.head;
+			if (node != NULL)
+			{
+				vsf_dlist_remove(&mal_async->queue, node);
+			}
+			vsf_leave_critical();
+			if (NULL == node)
+			{
+				return;
+			}
+			req = vsf_dlist_get_container(node, struct mal_async_req_t, node);
+			mal_async->cur = req;
+		}
+		
+		err = mal_async_run(mal_async, req);
+		if (err > 0)
+		{
+			// device busy, poll again later
+			mal_async_repoll(mal_async, mal_async->poll_interval);
+			return;
+		}
+		if (!err && (req->state != MAL_ASYNC_STATE_DONE))
+		{
+			// one page is done, let other state machines run
+			mal_async_repoll(mal_async, 0);
+			return;
+		}
+		
+		req->err = err;
+		mal_async->cur = NULL;
+		if (req->sm != NULL)
+		{
+			// if failed, req->err is the only way to know the completion
+			vsfsm_post_evt_pending(req->sm, req->evt);
+		}
+	}
+}
+
+static struct vsfsm_state_t *
+mal_async_evt_handler(struct vsfsm_t *sm, vsfsm_evt_t evt)
+{
+	struct mal_async_t *mal_async = (struct mal_async_t *)sm->user_data;
+	
+	switch (evt)
+	{
+	case VSFSM_EVT_INIT:
+		mal_async->cur = NULL;
+		// fall through
+	case MAL_ASYNC_EVT_SUBMIT:
+		// only one poll is pending while a request is being processed
+		if (NULL == mal_async->cur)
+		{
+			mal_async_poll(mal_async);
+		}
+		break;
+	case MAL_ASYNC_EVT_POLL:
+		mal_async_poll(mal_async);
+		break;
+	}
+	return NULL;
+}
+
+vsf_err_t mal_async_init(struct mal_async_t *mal_async)
+{
+	if ((NULL == mal_async->info) || (NULL == mal_async->info->extra))
+	{
+		return VSFERR_INVALID_PARAMETER;
+	}
+	
+	vsf_dlist_init(&mal_async->queue);
+	memset(&mal_async->timer, 0, sizeof(mal_async->timer));
+	mal_async->timer.sm = &mal_async->sm;
+	mal_async->timer.evt = MAL_ASYNC_EVT_POLL;
+	mal_async->timer.mode = VSFTIMER_MODE_ONESHOT;
+	
+	memset(&mal_async->sm, 0, sizeof(mal_async->sm));
+	mal_async->sm.init_state.evt_handler = mal_async_evt_handler;
+	mal_async->sm.user_data = (void*)mal_async;
+	return vsfsm_init(&mal_async->sm);
+}
+
+vsf_err_t mal_async_submit(struct mal_async_t *mal_async,
+							struct mal_async_req_t *req)
+{
+	vsf_err_t err;
+	
+	if (req->op > MAL_ASYNC_OP_ERASE)
+	{
+		return VSFERR_INVALID_PARAMETER;
+	}
+	
+	req->cur = 0;
+	req->state = MAL_ASYNC_STATE_START;
+	req->err = VSFERR_NOT_READY;
+	vsf_dlist_init_node(&req->node);
+	vsf_enter_critical();
+	vsf_dlist_append(&mal_async->queue, &req->node);
+	vsf_leave_critical();
+	
+	err = vsfsm_post_evt_pending(&mal_async->sm, MAL_ASYNC_EVT_SUBMIT);
+	if (err)
+	{
+		// not submitted unless already taken by the sm
+		vsf_enter_critical();
+		if (vsf_dlist_is_in(&mal_async->queue, &req->node))
+		{
+			vsf_dlist_remove(&mal_async->queue, &req->node);
+		}
+		else
+		{
+			err = VSFERR_NONE;
+		}
+		vsf_leave_critical();
+	}
+	return err;
+}
+
+vsf_err_t mal_async_cancel(struct mal_async_t *mal_async,
+							struct mal_async_req_t *req)
+{
+	vsf_err_t err = VSFERR_NOT_AVAILABLE;
+	
+	vsf_enter_critical();
+	if (vsf_dlist_is_in(&mal_async->queue, &req->node))
+	{
+		vsf_dlist_remove(&mal_async->queue, &req->node);
+		err = VSFERR_NONE;
+	}
+	vsf_leave_critical();
+	return err;
+}
+
+#endif
@@ -0,0 +1,84 @@
+/***************************************************************************
+ *   Copyright (C) 2009 - 2010 by Simon Qian <SimonQian@SimonQian.com>     *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef __MAL_ASYNC_H_INCLUDED__
+#define __MAL_ASYNC_H_INCLUDED__
+
+#include "mal.h"
+#include "framework/vsfsm/vsfsm.h"
+#include "framework/vsftimer/vsftimer.h"
+#include "tool/list/list.h"
+
+enum mal_async_op_t
+{
+	MAL_ASYNC_OP_READ,
+	MAL_ASYNC_OP_WRITE,
+	MAL_ASYNC_OP_ERASE,
+};
+
+// address is in bytes, count is in pages of the op, buff is NULL for erase
+// evt is sent to sm when the request is done, with the result in err,
+// 		err is VSFERR_NOT_READY until then, if evt can not be posted because
+// 		the event queue of sm is full, the request is still done and checking
+// 		err is the only way to know it
+struct mal_async_req_t
+{
+	// enum mal_async_op_t
+	uint8_t op;
+	uint64_t address;
+	uint64_t count;
+	uint8_t *buff;
+	struct vsfsm_t *sm;
+	vsfsm_evt_t evt;
+	vsf_err_t err;
+	
+	// private
+	struct vsf_dlist_node_t node;
+	uint64_t cur;
+	uint8_t state;
+};
+
+// requests are processed one by one in the order of submission, the
+// 		_nb_start/_nb/_nb_isready/_nb_end hooks of the driver are called
+// 		from vsfsm_poll, so other state machines run while the device is busy
+// info MUST be initialized by mal.init or mal.init_nb, and MUST NOT be
+// 		accessed by other ways while requests are pending
+struct mal_async_t
+{
+	struct dal_info_t *info;
+	// ms between two polls of a busy device, allowing idle in between,
+	// 		0 to poll in every round of vsfsm_poll
+	uint32_t poll_interval;
+	
+	// private
+	struct vsfsm_t sm;
+	struct vsftimer_timer_t timer;
+	struct vsf_dlist_t queue;
+	struct mal_async_req_t *cur;
+};
+
+vsf_err_t mal_async_init(struct mal_async_t *mal_async);
+// can be called from interrupt, req is not queued if failed
+vsf_err_t mal_async_submit(struct mal_async_t *mal_async,
+							struct mal_async_req_t *req);
+// only requests not started can be canceled, no event will be sent
+vsf_err_t mal_async_cancel(struct mal_async_t *mal_async,
+							struct mal_async_req_t *req);
+
+#endif	// __MAL_ASYNC_H_INCLUDED__
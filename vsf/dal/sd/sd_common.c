@@ -22,45 +22,26 @@
 
 #include "../mal/mal.h"
 #include "../mal/mal_driver.h"
+#include "tool/crc/crc.h"
 
 #if DAL_SD_SPI_EN || DAL_SD_SDIO_EN
 
 #include "sd_common.h"
 
+static struct crc_model_t sd_crc7 =
+			CRC_MODEL(7, false, false, SD_CRC7_POLY, 0, 0, NULL, 1);
+static uint32_t sd_crc16_table[CRC_TABLE_SIZE(SD_CFG_CRC16_SLICE)];
+static struct crc_model_t sd_crc16 = CRC_MODEL(16, false, false,
+			SD_CRC16_POLY, 0, 0, sd_crc16_table, SD_CFG_CRC16_SLICE);
+
 uint8_t sd_spi_cmd_chksum(uint8_t *data, uint32_t num)
 {
-	uint8_t crc, mask, i;
-	uint32_t j;
-	
-	crc = 0;
-	for (j = 0; j < num; j++)
-	{
-		mask = data[j] & 0x80 ? 0x40 : 0x00;
-		if ((crc & 0x40) ^ mask)
-		{
-			crc <<= 1;
-			crc ^= SD_CRC7_POLY;
-		}
-		else
-		{
-			crc <<= 1;
-		}
-		crc ^= data[j];
-		
-		for (i = 0; i < 7; i++)
-		{
-			if (crc & 0x40)
-			{
-				crc <<= 1;
-				crc ^= SD_CRC7_POLY;
-			}
-			else
-			{
-				crc <<= 1;
-			}
-		}
-	}
-	return crc & 0x7F;
+	return (uint8_t)crc_calc(&sd_crc7, data, num);
+}
+
+uint16_t sd_data_chksum(uint8_t *data, uint32_t num)
+{
+	return (uint16_t)crc_calc(&sd_crc16, data, num);
 }
 
 vsf_err_t sd_parse_csd(uint8_t *csd, struct sd_info_t *info)
@@ -22,6 +22,13 @@
 
 // 7-bit checksum polynomial: x7 + x3 + 1.
 #define SD_CRC7_POLY						0x09
+// 16-bit checksum polynomial for data: x16 + x12 + x5 + 1.
+#define SD_CRC16_POLY						0x1021
+
+// slice of the CRC16 table, 1, 4 or 8, table takes 1K bytes for each slice
+#ifndef SD_CFG_CRC16_SLICE
+#	define SD_CFG_CRC16_SLICE				1
+#endif
 
 // Resets all cards to idle state.
 #define SD_CMD(cmd)							(cmd)
@@ -197,6 +204,7 @@ struct sd_param_t
 };
 
 uint8_t sd_spi_cmd_chksum(uint8_t *data, uint32_t num);
+uint16_t sd_data_chksum(uint8_t *data, uint32_t num);
 vsf_err_t sd_parse_csd(uint8_t *csd, struct sd_info_t *info);
 
 #endif	// __SD_COMMON_H_INCLUDED__
@@ -257,21 +257,31 @@ static vsf_err_t sd_spi_transact_datablock(
 	struct sd_spi_drv_interface_t *ifs, struct sd_spi_drv_info_t *drv_info,
 	uint16_t token, uint8_t *buffer, uint32_t block_size)
 {
-	uint16_t dummy_crc16;
+	uint8_t crc16[2];
 	
 	if (token & SD_TRANSTOKEN_DATA_IN)
 	{
 		interfaces->spi.io(ifs->spi_port, NULL, buffer, (uint16_t)block_size);
-		interfaces->spi.io(ifs->spi_port, NULL, (uint8_t *)&dummy_crc16, 2);
+		interfaces->spi.io(ifs->spi_port, NULL, crc16, 2);
+		if (interfaces->peripheral_commit())
+		{
+			return VSFERR_FAIL;
+		}
+		if (GET_BE_U16(crc16) != sd_data_chksum(buffer, block_size))
+		{
+			return VSFERR_IO;
+		}
 		drv_info->cur_block++;
+		return VSFERR_NONE;
 	}
 	else
 	{
+		SET_BE_U16(crc16, sd_data_chksum(buffer, block_size));
 		interfaces->spi.io(ifs->spi_port, buffer, NULL, (uint16_t)block_size);
-		interfaces->spi.io(ifs->spi_port, (uint8_t *)&dummy_crc16, NULL, 2);
+		interfaces->spi.io(ifs->spi_port, crc16, NULL, 2);
 		drv_info->state = SD_SPI_DRV_WAITDATATOK;
+		return interfaces->peripheral_commit();
 	}
-	return interfaces->peripheral_commit();
 }
 
 static vsf_err_t sd_spi_transact_datablock_isready(
@@ -541,7 +551,9 @@ static vsf_err_t sd_spi_drv_init_nb_isready(struct dal_info_t *info)
 								SPI_MODE3 | SPI_MSB_FIRST | SPI_MASTER) || 
 		interfaces->peripheral_commit() || 
 		sd_spi_transact(ifs, drv_info, SD_TRANSTOKEN_RESP_R1,
-				SD_CMD_SET_BLOCKLEN, 512, &resp_r1, NULL, NULL, 0, 0))
+				SD_CMD_SET_BLOCKLEN, 512, &resp_r1, NULL, NULL, 0, 0) || 
+		sd_spi_transact(ifs, drv_info, SD_TRANSTOKEN_RESP_R1,
+				SD_CMD_CRC_ON_OFF, SD_CMD59_CRC_OPT, &resp_r1, NULL, NULL, 0, 0))
 	{
 		return VSFERR_FAIL;
 	}
@@ -582,8 +594,8 @@ static vsf_err_t sd_spi_getinfo(struct dal_info_t *info)
 	return VSFERR_NONE;
 }
 
-static vsf_err_t sd_spi_drv_readblock_nb_start(struct dal_info_t *info, 
-								uint64_t address, uint64_t count, uint8_t *buff)
+static vsf_err_t sd_spi_drv_readblock_cmd(struct dal_info_t *info,
+											uint64_t address)
 {
 	struct sd_spi_drv_info_t *drv_info = (struct sd_spi_drv_info_t *)info->info;
 	struct sd_spi_drv_interface_t *ifs = 
@@ -594,7 +606,6 @@ static vsf_err_t sd_spi_drv_readblock_nb_start(struct dal_info_t *info,
 	uint32_t arg;
 	uint8_t resp;
 	
-	REFERENCE_PARAMETER(buff);
 	if (SD_CARDTYPE_SD_V2HC == sd_info->cardtype)
 	{
 		arg = (uint32_t)(address >> 9);
@@ -604,13 +615,59 @@ static vsf_err_t sd_spi_drv_readblock_nb_start(struct dal_info_t *info,
 		arg = (uint32_t)address;
 	}
 	
-	drv_info->total_block = count;
 	token = SD_TRANSTOKEN_RESP_R1 | SD_TRANSTOKEN_DATA_IN;
-	if (sd_spi_transact_start(ifs) || 
-		sd_spi_transact_cmd(ifs, drv_info, token, SD_CMD_READ_MULTIPLE_BLOCK,
+	if (sd_spi_transact_cmd(ifs, drv_info, token, SD_CMD_READ_MULTIPLE_BLOCK,
 							arg) || 
 		sd_spi_transact_cmd_waitready(ifs, drv_info, token, &resp, NULL) || 
 		(resp != SD_CS8_NONE))
+	{
+		return VSFERR_FAIL;
+	}
+	return VSFERR_NONE;
+}
+
+// stop current multiple block read and restart it from address
+static vsf_err_t sd_spi_drv_readblock_restart(struct dal_info_t *info,
+											uint64_t address)
+{
+	struct sd_spi_drv_info_t *drv_info = (struct sd_spi_drv_info_t *)info->info;
+	struct sd_spi_drv_interface_t *ifs = 
+								(struct sd_spi_drv_interface_t *)info->ifs;
+	uint64_t cur_block = drv_info->cur_block;
+	uint16_t token;
+	uint8_t resp;
+	
+	token = SD_TRANSTOKEN_RESP_R1B;
+	if (sd_spi_transact_cmd(ifs, drv_info, token, SD_CMD_STOP_TRANSMISSION,
+							0) || 
+		sd_spi_transact_cmd_waitready(ifs, drv_info, token, &resp, NULL) || 
+		sd_spi_drv_readblock_cmd(info, address))
+	{
+		return VSFERR_FAIL;
+	}
+	// sd_spi_transact_cmd will reset cur_block
+	drv_info->cur_block = cur_block;
+	
+	token = SD_TRANSTOKEN_RESP_R1 | SD_TRANSTOKEN_DATA_IN;
+	sd_spi_transact_datablock_init(ifs, drv_info, token,
+										(uint32_t)drv_info->total_block, 512);
+	return sd_spi_transact_datablock_waitready(ifs, drv_info, token);
+}
+
+static vsf_err_t sd_spi_drv_readblock_nb_start(struct dal_info_t *info, 
+								uint64_t address, uint64_t count, uint8_t *buff)
+{
+	struct sd_spi_drv_info_t *drv_info = (struct sd_spi_drv_info_t *)info->info;
+	struct sd_spi_drv_interface_t *ifs = 
+								(struct sd_spi_drv_interface_t *)info->ifs;
+	uint16_t token;
+	
+	REFERENCE_PARAMETER(buff);
+	
+	drv_info->total_block = count;
+	token = SD_TRANSTOKEN_RESP_R1 | SD_TRANSTOKEN_DATA_IN;
+	if (sd_spi_transact_start(ifs) || 
+		sd_spi_drv_readblock_cmd(info, address))
 	{
 		sd_spi_transact_end(ifs);
 		interfaces->peripheral_commit();
@@ -628,12 +685,21 @@ static vsf_err_t sd_spi_drv_readblock_nb(struct dal_info_t *info,
 	struct sd_spi_drv_interface_t *ifs = 
 								(struct sd_spi_drv_interface_t *)info->ifs;
 	uint16_t token;
-	
-	REFERENCE_PARAMETER(address);
+	uint8_t retry = SD_SPI_CRC_RETRY;
+	vsf_err_t err;
 	
 	token = SD_TRANSTOKEN_RESP_R1 | SD_TRANSTOKEN_DATA_IN;
-	if (sd_spi_transact_datablock(ifs, drv_info, token, buff, 512) ||
-		sd_spi_transact_datablock_fini(ifs, drv_info, token))
+	err = sd_spi_transact_datablock(ifs, drv_info, token, buff, 512);
+	while ((VSFERR_IO == err) && retry--)
+	{
+		// CRC error, read the block again
+		err = sd_spi_drv_readblock_restart(info, address);
+		if (!err)
+		{
+			err = sd_spi_transact_datablock(ifs, drv_info, token, buff, 512);
+		}
+	}
+	if (err || sd_spi_transact_datablock_fini(ifs, drv_info, token))
 	{
 		sd_spi_transact_end(ifs);
 		interfaces->peripheral_commit();
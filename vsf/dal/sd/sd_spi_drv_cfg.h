@@ -18,4 +18,6 @@
  ***************************************************************************/
 
 #define SD_SPI_CMD_TIMEOUT					32
+// retry count of a data block with CRC error
+#define SD_SPI_CRC_RETRY					3
 
@@ -22,55 +22,220 @@
 
 #include "stream.h"
 
+enum stream_evt_t
+{
+	STREAM_EVT_FLUSH_ARM = VSFSM_EVT_USER_LOCAL + 0,
+	STREAM_EVT_FLUSH_TO = VSFSM_EVT_USER_LOCAL + 1,
+};
+
+static struct vsfsm_state_t *
+stream_evt_handler(struct vsfsm_t *sm, vsfsm_evt_t evt)
+{
+	struct vsf_stream_t *stream = (struct vsf_stream_t *)sm->user_data;
+	
+	switch (evt)
+	{
+	case STREAM_EVT_FLUSH_ARM:
+		stream->flush_timer.sm = sm;
+		stream->flush_timer.evt = STREAM_EVT_FLUSH_TO;
+		stream->flush_timer.mode = VSFTIMER_MODE_ONESHOT;
+		stream->flush_timer.interval = stream->flush_timeout;
+		vsftimer_register(&stream->flush_timer);
+		break;
+	case STREAM_EVT_FLUSH_TO:
+		stream->flush_armed = false;
+		if ((stream->callback_rx.on_in_int != NULL) &&
+			(vsf_ring_get_data_length(&stream->ring) > 0))
+		{
+			stream->callback_rx.on_in_int(stream->callback_rx.param);
+		}
+		break;
+	}
+	return NULL;
+}
+
+static void stream_flush_arm(struct vsf_stream_t *stream)
+{
+	if (stream->flush_timeout && !stream->flush_armed)
+	{
+		stream->flush_armed = true;
+		// event queue full, clear to arm again on the next write
+		if (vsfsm_post_evt_pending(&stream->sm, STREAM_EVT_FLUSH_ARM))
+		{
+			stream->flush_armed = false;
+		}
+	}
+}
+
+// called after data_size is increased from before
+static void stream_notify_rx(struct vsf_stream_t *stream, uint32_t before)
+{
+	uint32_t after = vsf_ring_get_data_length(&stream->ring);
+	uint32_t threshold = stream->rx_threshold;
+	
+	if (stream->callback_rx.on_in_int == NULL)
+	{
+		return;
+	}
+	if (!threshold || ((before < threshold) && (after >= threshold)))
+	{
+		stream->callback_rx.on_in_int(stream->callback_rx.param);
+	}
+	else if (after < threshold)
+	{
+		stream_flush_arm(stream);
+	}
+}
+
+// called after free_size is increased from before
+static void stream_notify_tx(struct vsf_stream_t *stream, uint32_t before)
+{
+	uint32_t after = vsf_ring_get_avail_length(&stream->ring);
+	uint32_t threshold = stream->tx_threshold;
+	uint32_t data_size;
+	
+	if ((stream->callback_tx.on_out_int != NULL) &&
+		(!threshold || ((before < threshold) && (after >= threshold))))
+	{
+		stream->callback_tx.on_out_int(stream->callback_tx.param);
+	}
+	
+	// data left below rx_threshold will not wake up the rx end again
+	data_size = vsf_ring_get_data_length(&stream->ring);
+	if ((data_size > 0) && (data_size < stream->rx_threshold))
+	{
+		stream_flush_arm(stream);
+	}
+}
+
 vsf_err_t stream_init(struct vsf_stream_t *stream)
 {
 	stream->overflow = false;
 	stream->tx_ready = false;
 	stream->rx_ready = false;
-	vsf_fifo_init(&stream->fifo);
-	return VSFERR_NONE;
+	stream->flush_armed = false;
+	if (stream->flush_timeout)
+	{
+		memset(&stream->flush_timer, 0, sizeof(stream->flush_timer));
+		memset(&stream->sm, 0, sizeof(stream->sm));
+		stream->sm.init_state.evt_handler = stream_evt_handler;
+		stream->sm.user_data = (void*)stream;
+		if (vsfsm_init(&stream->sm))
+		{
+			return VSFERR_FAIL;
+		}
+	}
+	return vsf_ring_init(&stream->ring);
 }
 
 vsf_err_t stream_fini(struct vsf_stream_t *stream)
 {
-	REFERENCE_PARAMETER(stream);
+	if (stream->flush_timeout)
+	{
+		vsftimer_unregister(&stream->flush_timer);
+#if VSFSM_CFG_ACTIVE_EN
+		vsfsm_set_active(&stream->sm, false);
+#endif
+	}
 	return VSFERR_NONE;
 }
 
 uint32_t stream_rx(struct vsf_stream_t *stream, struct vsf_buffer_t *buffer)
 {
-	uint32_t count = vsf_fifo_pop(&stream->fifo, buffer->size, buffer->buffer);
+	uint32_t before = vsf_ring_get_avail_length(&stream->ring);
+	uint32_t count = vsf_ring_pop(&stream->ring, buffer->size, buffer->buffer);
 	
-	if ((stream->callback_tx.on_out_int != NULL) && (count > 0))
+	if (count > 0)
 	{
-		stream->callback_tx.on_out_int(stream->callback_tx.param);
+		stream_notify_tx(stream, before);
 	}
 	return count;
 }
 
 uint32_t stream_tx(struct vsf_stream_t *stream, struct vsf_buffer_t *buffer)
 {
-	uint32_t count = vsf_fifo_push(&stream->fifo, buffer->size, buffer->buffer);
+	uint32_t before = vsf_ring_get_data_length(&stream->ring);
+	uint32_t count = vsf_ring_push(&stream->ring, buffer->size, buffer->buffer);
 	
 	if (count < buffer->size)
 	{
 		stream->overflow = true;
 	}
-	if ((stream->callback_rx.on_in_int != NULL) && (count > 0))
+	if (count > 0)
 	{
-		stream->callback_rx.on_in_int(stream->callback_rx.param);
+		stream_notify_rx(stream, before);
+	}
+	return count;
+}
+
+uint32_t stream_tx_list(struct vsf_stream_t *stream,
+						struct vsf_buffer_list_t *list)
+{
+	uint32_t before = vsf_ring_get_data_length(&stream->ring);
+	uint32_t count = vsf_buffer_list_get_size(list);
+	
+	if (count > vsf_ring_get_avail_length(&stream->ring))
+	{
+		stream->overflow = true;
+		return 0;
+	}
+	for (; list != NULL; list = list->next)
+	{
+		vsf_ring_push(&stream->ring, list->buffer.size, list->buffer.buffer);
+	}
+	if (count > 0)
+	{
+		stream_notify_rx(stream, before);
+	}
+	return count;
+}
+
+uint32_t stream_get_wbuf(struct vsf_stream_t *stream, uint8_t **data)
+{
+	return vsf_ring_get_wbuf(&stream->ring, data);
+}
+
+uint32_t stream_commit_write(struct vsf_stream_t *stream, uint32_t size)
+{
+	uint32_t before = vsf_ring_get_data_length(&stream->ring);
+	uint32_t count = vsf_ring_commit_write(&stream->ring, size);
+	
+	if (count < size)
+	{
+		stream->overflow = true;
+	}
+	if (count > 0)
+	{
+		stream_notify_rx(stream, before);
+	}
+	return count;
+}
+
+uint32_t stream_get_rbuf(struct vsf_stream_t *stream, uint8_t **data)
+{
+	return vsf_ring_get_rbuf(&stream->ring, data);
+}
+
+uint32_t stream_commit_read(struct vsf_stream_t *stream, uint32_t size)
+{
+	uint32_t before = vsf_ring_get_avail_length(&stream->ring);
+	uint32_t count = vsf_ring_commit_read(&stream->ring, size);
+	
+	if (count > 0)
+	{
+		stream_notify_tx(stream, before);
 	}
 	return count;
 }
 
 uint32_t stream_get_data_size(struct vsf_stream_t *stream)
 {
-	return vsf_fifo_get_data_length(&stream->fifo);
+	return vsf_ring_get_data_length(&stream->ring);
 }
 
 uint32_t stream_get_free_size(struct vsf_stream_t *stream)
 {
-	return vsf_fifo_get_avail_length(&stream->fifo);
+	return vsf_ring_get_avail_length(&stream->ring);
 }
 
 void stream_connect_rx(struct vsf_stream_t *stream)
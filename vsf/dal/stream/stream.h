@@ -21,10 +21,15 @@
 #define __STREAM_H_INCLUDED__
 
 #include "tool/buffer/buffer.h"
+#include "framework/vsfsm/vsfsm.h"
+#include "framework/vsftimer/vsftimer.h"
 
 struct vsf_stream_t
 {
-	struct vsf_fifo_t fifo;
+	// size of the ring buffer MUST be power of 2
+	// single-producer single-consumer, so tx end and rx end can run in
+	// 		different contexts without locking
+	struct vsf_ring_t ring;
 	// callback_tx is notification for tx end of the stream
 	// when rx end read the data out, will notify the tx end
 	struct
@@ -41,15 +46,46 @@ struct vsf_stream_t
 		void (*on_in_int)(void *param);
 		void (*on_connect_tx)(void *param);
 	} callback_rx;
+	// notifications are edge-triggered, a notified end MUST keep on
+	// 		processing until the level falls below the threshold again
+	// rx end is notified when the data size rises to rx_threshold,
+	// 		0 to notify on every write
+	uint32_t rx_threshold;
+	// tx end is notified when the free size rises to tx_threshold,
+	// 		0 to notify on every read
+	uint32_t tx_threshold;
+	// in ms, rx end is notified if data below rx_threshold is left
+	// 		in the stream for flush_timeout, 0 to disable
+	uint32_t flush_timeout;
+	
 	bool tx_ready;
 	bool rx_ready;
 	bool overflow;
+	
+	// private
+	// flush_timer is armed in the sm, because stream_tx can be called
+	// 		in interrupt and vsftimer_register is not interrupt-safe
+	struct vsfsm_t sm;
+	struct vsftimer_timer_t flush_timer;
+	volatile bool flush_armed;
 };
 
 vsf_err_t stream_init(struct vsf_stream_t *stream);
 vsf_err_t stream_fini(struct vsf_stream_t *stream);
 uint32_t stream_rx(struct vsf_stream_t *stream, struct vsf_buffer_t *buffer);
 uint32_t stream_tx(struct vsf_stream_t *stream, struct vsf_buffer_t *buffer);
+// all segments in the list are written, or none if not enough space
+uint32_t stream_tx_list(struct vsf_stream_t *stream,
+						struct vsf_buffer_list_t *list);
+// zero-copy access to the ring of the stream
+// get_wbuf/get_rbuf return the size of the largest contiguous span to be
+// 		written/read, and the span is returned in data
+// commit_write/commit_read publish size bytes in the span, and notify the
+// 		other end the same way as stream_tx/stream_rx, once per commit
+uint32_t stream_get_wbuf(struct vsf_stream_t *stream, uint8_t **data);
+uint32_t stream_commit_write(struct vsf_stream_t *stream, uint32_t size);
+uint32_t stream_get_rbuf(struct vsf_stream_t *stream, uint8_t **data);
+uint32_t stream_commit_read(struct vsf_stream_t *stream, uint32_t size);
 uint32_t stream_get_data_size(struct vsf_stream_t *stream);
 uint32_t stream_get_free_size(struct vsf_stream_t *stream);
 void stream_connect_rx(struct vsf_stream_t *stream);
@@ -0,0 +1,238 @@
+/***************************************************************************
+ *   Copyright (C) 2009 - 2010 by Simon Qian <SimonQian@SimonQian.com>     *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "app_cfg.h"
+#include "app_type.h"
+
+#include "stream_mux.h"
+
+enum stream_mux_evt_t
+{
+	STREAM_MUX_EVT_POLL = VSFSM_EVT_USER_LOCAL + 0,
+};
+
+static void stream_mux_callback(void *p)
+{
+	struct vsf_stream_mux_t *mux = (struct vsf_stream_mux_t *)p;
+	
+	vsfsm_post_evt_coalesce(&mux->sm, STREAM_MUX_EVT_POLL);
+}
+
+static void stream_mux_rx_frame(struct vsf_stream_mux_t *mux)
+{
+	struct vsf_stream_mux_channel_t *channel;
+	
+	if ((mux->rx_frame[0] != STREAM_MUX_CTRL_ID) ||
+		(mux->rx_frame[1] != STREAM_MUX_CREDIT_SIZE) ||
+		(mux->rx_frame[2] >= mux->channel_num))
+	{
+		return;
+	}
+	channel = &mux->channel[mux->rx_frame[2]];
+	channel->tx_credit += GET_LE_U16(&mux->rx_frame[3]);
+}
+
+static void stream_mux_rx(struct vsf_stream_mux_t *mux)
+{
+	struct vsf_stream_mux_channel_t *channel;
+	struct vsf_buffer_t buffer;
+	uint32_t size, remain;
+	uint8_t *data;
+	
+	while ((size = stream_get_rbuf(mux->stream_rx, &data)) > 0)
+	{
+		if (mux->rx_pos < STREAM_MUX_HEAD_SIZE)
+		{
+			mux->rx_frame[mux->rx_pos++] = *data;
+			size = 1;
+		}
+		else
+		{
+			remain = STREAM_MUX_HEAD_SIZE + mux->rx_frame[1] - mux->rx_pos;
+			size = min(size, remain);
+			if ((mux->rx_frame[0] == STREAM_MUX_CTRL_ID) &&
+				(mux->rx_pos < sizeof(mux->rx_frame)))
+			{
+				remain = sizeof(mux->rx_frame) - mux->rx_pos;
+				memcpy(&mux->rx_frame[mux->rx_pos], data, min(size, remain));
+			}
+			else if (mux->rx_frame[0] < mux->channel_num)
+			{
+				channel = &mux->channel[mux->rx_frame[0]];
+				buffer.buffer = data;
+				buffer.size = size;
+				stream_tx(&channel->stream_rx, &buffer);
+				channel->rx_credit -= min(size, channel->rx_credit);
+			}
+			mux->rx_pos += size;
+		}
+		stream_commit_read(mux->stream_rx, size);
+		
+		if ((mux->rx_pos >= STREAM_MUX_HEAD_SIZE) &&
+			(mux->rx_pos == (STREAM_MUX_HEAD_SIZE + mux->rx_frame[1])))
+		{
+			stream_mux_rx_frame(mux);
+			mux->rx_pos = 0;
+		}
+	}
+}
+
+static void stream_mux_tx(struct vsf_stream_mux_t *mux)
+{
+	struct vsf_stream_mux_channel_t *channel;
+	uint8_t frame[STREAM_MUX_HEAD_SIZE + STREAM_MUX_CREDIT_SIZE];
+	struct vsf_buffer_list_t head, payload;
+	uint32_t size, grant;
+	bool progress;
+	uint8_t i;
+	
+	head.buffer.buffer = frame;
+	
+	// credits first, so that the peer will not wait for the data
+	for (i = 0; i < mux->channel_num; i++)
+	{
+		channel = &mux->channel[i];
+		size = stream_get_free_size(&channel->stream_rx);
+		grant = (size > channel->rx_credit) ? size - channel->rx_credit : 0;
+		grant = min(grant, 0xFFFF);
+		// grant in batches of half the ring, unless the peer is blocked
+		if (!grant || (channel->rx_credit &&
+				(grant < (channel->stream_rx.ring.buffer.size >> 1))))
+		{
+			continue;
+		}
+		if (stream_get_free_size(mux->stream_tx) < sizeof(frame))
+		{
+			// retry when stream_tx is read
+			return;
+		}
+		frame[0] = STREAM_MUX_CTRL_ID;
+		frame[1] = STREAM_MUX_CREDIT_SIZE;
+		frame[2] = i;
+		SET_LE_U16(&frame[3], grant);
+		head.buffer.size = sizeof(frame);
+		head.next = NULL;
+		stream_tx_list(mux->stream_tx, &head);
+		channel->rx_credit += grant;
+	}
+	
+	// one frame for every channel in a round, until nothing can be sent
+	do
+	{
+		progress = false;
+		for (i = 0; i < mux->channel_num; i++)
+		{
+			channel = &mux->channel[i];
+			size = stream_get_free_size(mux->stream_tx);
+			if (size <= STREAM_MUX_HEAD_SIZE)
+			{
+				return;
+			}
+			size = min(size - STREAM_MUX_HEAD_SIZE, channel->tx_credit);
+			size = min(size, STREAM_MUX_MAX_PAYLOAD);
+			size = min(size, stream_get_rbuf(&channel->stream_tx,
+												&payload.buffer.buffer));
+			if (!size)
+			{
+				continue;
+			}
+			
+			frame[0] = i;
+			frame[1] = (uint8_t)size;
+			head.buffer.size = STREAM_MUX_HEAD_SIZE;
+			head.next = &payload;
+			payload.buffer.size = size;
+			payload.next = NULL;
+			stream_tx_list(mux->stream_tx, &head);
+			stream_commit_read(&channel->stream_tx, size);
+			channel->tx_credit -= size;
+			progress = true;
+		}
+	} while (progress);
+}
+
+static struct vsfsm_state_t *
+stream_mux_evt_handler(struct vsfsm_t *sm, vsfsm_evt_t evt)
+{
+	struct vsf_stream_mux_t *mux = (struct vsf_stream_mux_t *)sm->user_data;
+	struct vsf_stream_mux_channel_t *channel;
+	uint8_t i;
+	
+	switch (evt)
+	{
+	case VSFSM_EVT_INIT:
+		// mux is the tx end of stream_tx and the rx end of stream_rx
+		mux->stream_tx->callback_tx.param = mux;
+		mux->stream_tx->callback_tx.on_out_int = stream_mux_callback;
+		mux->stream_tx->callback_tx.on_connect_rx = stream_mux_callback;
+		mux->stream_rx->callback_rx.param = mux;
+		mux->stream_rx->callback_rx.on_in_int = stream_mux_callback;
+		mux->stream_rx->callback_rx.on_connect_tx = stream_mux_callback;
+		for (i = 0; i < mux->channel_num; i++)
+		{
+			channel = &mux->channel[i];
+			channel->tx_credit = 0;
+			channel->rx_credit = 0;
+			
+			// and is the rx end of stream_tx and the tx end of stream_rx
+			// 		of the channels
+			channel->stream_tx.callback_rx.param = mux;
+			channel->stream_tx.callback_rx.on_in_int = stream_mux_callback;
+			channel->stream_tx.callback_rx.on_connect_tx = stream_mux_callback;
+			channel->stream_rx.callback_tx.param = mux;
+			channel->stream_rx.callback_tx.on_out_int = stream_mux_callback;
+			channel->stream_rx.callback_tx.on_connect_rx = stream_mux_callback;
+			stream_connect_rx(&channel->stream_tx);
+			stream_connect_tx(&channel->stream_rx);
+		}
+		mux->rx_pos = 0;
+		stream_connect_tx(mux->stream_tx);
+		stream_connect_rx(mux->stream_rx);
+		// fall through
+	case STREAM_MUX_EVT_POLL:
+		stream_mux_rx(mux);
+		stream_mux_tx(mux);
+		break;
+	}
+	return NULL;
+}
+
+vsf_err_t stream_mux_init(struct vsf_stream_mux_t *mux)
+{
+	if ((NULL == mux->stream_tx) || (NULL == mux->stream_rx) ||
+		(mux->channel_num >= STREAM_MUX_CTRL_ID))
+	{
+		return VSFERR_INVALID_PARAMETER;
+	}
+	
+	memset(&mux->sm, 0, sizeof(mux->sm));
+	mux->sm.init_state.evt_handler = stream_mux_evt_handler;
+	mux->sm.user_data = (void*)mux;
+	return vsfsm_init(&mux->sm);
+}
+
+vsf_err_t stream_mux_fini(struct vsf_stream_mux_t *mux)
+{
+#if VSFSM_CFG_ACTIVE_EN
+	return vsfsm_set_active(&mux->sm, false);
+#else
+	REFERENCE_PARAMETER(mux);
+	return VSFERR_NONE;
+#endif
+}
@@ -0,0 +1,73 @@
+/***************************************************************************
+ *   Copyright (C) 2009 - 2010 by Simon Qian <SimonQian@SimonQian.com>     *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef __STREAM_MUX_H_INCLUDED__
+#define __STREAM_MUX_H_INCLUDED__
+
+#include "dal/stream/stream.h"
+
+// logical channels are carried over one physical stream in frames of
+// 		channel id(1 byte) + payload length(1 byte) + payload
+// frame with STREAM_MUX_CTRL_ID carries credit of a channel:
+// 		channel id(1 byte) + credit in bytes(2 bytes little endian)
+#define STREAM_MUX_CTRL_ID				0xFF
+#define STREAM_MUX_HEAD_SIZE			2
+#define STREAM_MUX_CREDIT_SIZE			3
+#define STREAM_MUX_MAX_PAYLOAD			0xFF
+
+// data to the peer is limited by the credit granted by the peer, which is the
+// 		free space of the stream_rx of the channel in the peer, so frames are
+// 		never dropped for overflow in the demux
+struct vsf_stream_mux_channel_t
+{
+	// written by user, muxed to the physical stream
+	struct vsf_stream_t stream_tx;
+	// demuxed from the physical stream, read by user
+	struct vsf_stream_t stream_rx;
+	
+	// private
+	// bytes can be sent to the peer
+	uint32_t tx_credit;
+	// bytes granted to the peer, but not received yet
+	uint32_t rx_credit;
+};
+
+// stream_tx and stream_rx of the channels and the physical streams MUST be
+// 		initialized by user
+// frames of all channels are written back to back into stream_tx, to send
+// 		small writes in full packets, set rx_threshold of stream_tx to the
+// 		packet size with a flush_timeout
+struct vsf_stream_mux_t
+{
+	struct vsf_stream_t *stream_tx;
+	struct vsf_stream_t *stream_rx;
+	struct vsf_stream_mux_channel_t *channel;
+	uint8_t channel_num;
+	
+	// private
+	struct vsfsm_t sm;
+	// header and credit of the frame being demuxed
+	uint8_t rx_frame[STREAM_MUX_HEAD_SIZE + STREAM_MUX_CREDIT_SIZE];
+	uint32_t rx_pos;
+};
+
+vsf_err_t stream_mux_init(struct vsf_stream_mux_t *mux);
+vsf_err_t stream_mux_fini(struct vsf_stream_mux_t *mux);
+
+#endif	// __STREAM_MUX_H_INCLUDED__
@@ -0,0 +1,151 @@
+/***************************************************************************
+ *   Copyright (C) 2009 - 2010 by Simon Qian <SimonQian@SimonQian.com>     *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "app_cfg.h"
+#include "app_type.h"
+
+#include "stream_tee.h"
+
+static void stream_tee_on_out_int(void *param)
+{
+	struct vsf_stream_tee_t *tee = (struct vsf_stream_tee_t *)param;
+	
+	if (tee->callback_tx.on_out_int != NULL)
+	{
+		tee->callback_tx.on_out_int(tee->callback_tx.param);
+	}
+}
+
+static void stream_tee_on_connect_rx(void *param)
+{
+	REFERENCE_PARAMETER(param);
+}
+
+vsf_err_t stream_tee_init(struct vsf_stream_tee_t *tee)
+{
+	struct vsf_stream_t *stream;
+	uint8_t i;
+	
+	if (tee->stream_num > 32)
+	{
+		return VSFERR_INVALID_PARAMETER;
+	}
+	
+	tee->head = 0;
+	for (i = 0; i < tee->stream_num; i++)
+	{
+		stream = tee->stream[i];
+		stream->ring.buffer = tee->buffer;
+		if (stream_init(stream))
+		{
+			return VSFERR_INVALID_PARAMETER;
+		}
+		
+		// reading of consumers in drop_mask will not unblock the producer
+		stream->callback_tx.param = tee;
+		stream->callback_tx.on_out_int = (tee->drop_mask & (1UL << i)) ?
+										NULL : stream_tee_on_out_int;
+		stream->callback_tx.on_connect_rx = stream_tee_on_connect_rx;
+		stream_connect_tx(stream);
+	}
+	return VSFERR_NONE;
+}
+
+uint32_t stream_tee_get_free_size(struct vsf_stream_tee_t *tee)
+{
+	uint32_t free_size = tee->buffer.size, size;
+	uint8_t i;
+	
+	for (i = 0; i < tee->stream_num; i++)
+	{
+		if (!(tee->drop_mask & (1UL << i)))
+		{
+			size = stream_get_free_size(tee->stream[i]);
+			free_size = min(free_size, size);
+		}
+	}
+	return free_size;
+}
+
+uint32_t stream_tee_tx(struct vsf_stream_tee_t *tee,
+						struct vsf_buffer_t *buffer)
+{
+	uint32_t size = min(buffer->size, stream_tee_get_free_size(tee));
+	uint32_t offset = tee->head & (tee->buffer.size - 1);
+	uint32_t first = min(size, tee->buffer.size - offset);
+	uint32_t drop = 0;
+	struct vsf_stream_t *stream;
+	uint8_t i;
+	
+	if (size < buffer->size)
+	{
+		for (i = 0; i < tee->stream_num; i++)
+		{
+			tee->stream[i]->overflow = true;
+		}
+	}
+	if (!size)
+	{
+		return 0;
+	}
+	
+	for (i = 0; i < tee->stream_num; i++)
+	{
+		if ((tee->drop_mask & (1UL << i)) &&
+			(stream_get_free_size(tee->stream[i]) < size))
+		{
+			drop |= 1UL << i;
+		}
+	}
+	
+	// the oldest data of the dropped consumers is overwritten, so the
+	// 		consumers MUST NOT read in the middle
+	if (drop)
+	{
+		vsf_enter_critical();
+		for (i = 0; i < tee->stream_num; i++)
+		{
+			if (drop & (1UL << i))
+			{
+				stream = tee->stream[i];
+				stream->ring.tail = tee->head + size - tee->buffer.size;
+				stream->overflow = true;
+			}
+		}
+	}
+	memcpy(&tee->buffer.buffer[offset], buffer->buffer, first);
+	memcpy(tee->buffer.buffer, &buffer->buffer[first], size - first);
+	if (drop)
+	{
+		vsf_leave_critical();
+	}
+	tee->head += size;
+	
+	// commit at most 2 spans for every consumer, wrapped at end of buffer
+	for (i = 0; i < tee->stream_num; i++)
+	{
+		stream = tee->stream[i];
+		stream_commit_write(stream, first);
+		if (size > first)
+		{
+			stream_commit_write(stream, size - first);
+		}
+	}
+	return size;
+}
@@ -0,0 +1,59 @@
+/***************************************************************************
+ *   Copyright (C) 2009 - 2010 by Simon Qian <SimonQian@SimonQian.com>     *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef __STREAM_TEE_H_INCLUDED__
+#define __STREAM_TEE_H_INCLUDED__
+
+#include "dal/stream/stream.h"
+
+// data written to the tee is stored once in buffer, and read by every
+// 		consumer from its own stream, whose ring is set to buffer by the tee
+// 		so that each consumer has its own read cursor
+// a consumer in drop_mask will not block the producer, the oldest data of
+// 		the consumer is dropped instead, and overflow of the stream is set
+// a consumer in drop_mask MUST be read in the same context as the producer,
+// 		or in interrupt while the producer runs in task
+struct vsf_stream_tee_t
+{
+	// size of the buffer MUST be power of 2
+	struct vsf_buffer_t buffer;
+	struct vsf_stream_t **stream;
+	uint8_t stream_num;
+	uint32_t drop_mask;
+	
+	// notification for the producer when a consumer not in drop_mask
+	// 		read the data out
+	struct
+	{
+		void *param;
+		void (*on_out_int)(void *param);
+	} callback_tx;
+	
+	// private
+	uint32_t head;
+};
+
+vsf_err_t stream_tee_init(struct vsf_stream_tee_t *tee);
+// returns the size written, which is limited by the slowest consumer
+// 		not in drop_mask
+uint32_t stream_tee_tx(struct vsf_stream_tee_t *tee,
+						struct vsf_buffer_t *buffer);
+uint32_t stream_tee_get_free_size(struct vsf_stream_tee_t *tee);
+
+#endif	// __STREAM_TEE_H_INCLUDED__
@@ -67,8 +67,11 @@ void usart_stream_onrx_int(void *p, uint16_t data)
 vsf_err_t usart_stream_init(struct usart_stream_info_t *usart_stream)
 {
 	usart_stream->txing = false;
-	stream_init(&usart_stream->stream_tx);
-	stream_init(&usart_stream->stream_rx);
+	if (stream_init(&usart_stream->stream_tx) ||
+		stream_init(&usart_stream->stream_rx))
+	{
+		return VSFERR_INVALID_PARAMETER;
+	}
 	if (usart_stream->usart_index != IFS_DUMMY_PORT)
 	{
 #if IFS_USART_EN
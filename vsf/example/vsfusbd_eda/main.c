@@ -324,8 +324,8 @@ struct vsfapp_t
 			struct vsfusbd_CDCACM_param_t param;
 			struct vsf_stream_t stream_tx;
 			struct vsf_stream_t stream_rx;
-			uint8_t txbuff[65];
-			uint8_t rxbuff[65];
+			uint8_t txbuff[64];
+			uint8_t rxbuff[64];
 		} cdc;
 		struct vsfusbd_iface_t ifaces[3];
 		struct vsfusbd_config_t config[1];
@@ -385,13 +385,18 @@ struct vsfapp_t
 				{
 					(uint8_t *)&app.usbd.cdc.txbuff,
 					sizeof(app.usbd.cdc.txbuff),
-				},			// struct vsf_fifo_t fifo;
+				},			// struct vsf_ring_t ring;
+				{0},		// callback_tx
+				{0},		// callback_rx
+				32,			// uint32_t rx_threshold;
+				0,			// uint32_t tx_threshold;
+				2,			// uint32_t flush_timeout;
 			},				// struct vsf_stream_t stream_tx;
 			{
 				{
 					(uint8_t *)&app.usbd.cdc.rxbuff,
 					sizeof(app.usbd.cdc.rxbuff),
-				},			// struct vsf_fifo_t fifo;
+				},			// struct vsf_ring_t ring;
 			},				// struct vsf_stream_t stream_rx;
 		},						// struct cdc;
 		{
@@ -430,6 +435,7 @@ struct vsfapp_t
 		200,					// uint32_t interval;
 		&app.sm,				// struct vsfsm_t *sm;
 		APP_EVT_USBPU_TO,		// vsfsm_evt_t evt;
+		VSFTIMER_MODE_ONESHOT,	// uint8_t mode;
 	},							// struct vsftimer_timer_t usbpu_timer;
 };
 
@@ -474,7 +480,6 @@ app_evt_handler(struct vsfsm_t *sm, vsfsm_evt_t evt)
 										1 << app.usb_pullup.pin);
 		}
 		app.usbd.device.drv->connect();
-		vsftimer_unregister(&app.usbpu_timer);
 		break;
 	}
 	return NULL;
@@ -483,6 +488,9 @@ app_evt_handler(struct vsfsm_t *sm, vsfsm_evt_t evt)
 int main(void)
 {
 	vsf_leave_critical();
+#if VSFSM_CFG_PROFILE_EN
+	vsfsm_profile_register(&app.sm, "app");
+#endif
 	vsfsm_init(&app.sm);
 	while (1)
 	{
@@ -491,8 +499,15 @@ int main(void)
 		vsf_enter_critical();
 		if (!vsfsm_get_event_pending())
 		{
+			// tickless idle, no tick interrupt before the next timer expires
+			core_interfaces.tickclk.set_interval(vsftimer_get_idle_ticks());
 			// sleep, will also enable interrupt
 			core_interfaces.core.sleep(SLEEP_WFI);
+			// woken up by other interrupt, the long interval is still in
+			// 		the compare, and timers registered by the events of the
+			// 		interrupt will not be processed until it expires,
+			// 		so restore the tick of 1
+			core_interfaces.tickclk.set_interval(1);
 		}
 		else
 		{
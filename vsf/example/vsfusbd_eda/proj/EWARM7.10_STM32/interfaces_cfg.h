@@ -137,5 +137,6 @@
 #define IFS_EINT_EN							0
 #define IFS_EBI_EN							1
 #define IFS_SDIO_EN							0
+#define IFS_CRC_EN							0
 #define IFS_USBD_EN							1
 
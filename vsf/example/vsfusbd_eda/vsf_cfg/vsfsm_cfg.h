@@ -1,8 +1,14 @@
 #define VSFSM_CFG_EVTQ_SIZE				16
+#define VSFSM_CFG_PRIORITY_EN			1
+#define VSFSM_CFG_EVTQ_LOCKFREE_EN		0
+#define VSFSM_CFG_MAILBOX_EN			1
+#define VSFSM_CFG_PROFILE_EN			1
 #define VSFSM_CFG_SYNC_EN				1
+#define VSFSM_CFG_SYNC_TIMEOUT_EN		1
 #define VSFSM_CFG_ACTIVE_EN				0
 #define VSFSM_CFG_SM_EN					0
 #define VSFSM_CFG_SUBSM_EN				0
 #define VSFSM_CFG_HSM_EN				0
 #define VSFSM_CFG_PT_EN					1
 #define VSFSM_CFG_PT_STACK_EN			0
+#define VSFSM_CFG_THREAD_EN				0
@@ -35,9 +35,16 @@
 // handlers
 static vsf_err_t
 vsfshell_echo_handler(struct vsfsm_pt_t *pt, vsfsm_evt_t evt);
+#if VSFSM_CFG_PROFILE_EN
+static vsf_err_t
+vsfshell_top_handler(struct vsfsm_pt_t *pt, vsfsm_evt_t evt);
+#endif
 static struct vsfshell_handler_t vsfshell_handlers[] =
 {
 	VSFSHELL_HANDLER("echo", vsfshell_echo_handler),
+#if VSFSM_CFG_PROFILE_EN
+	VSFSHELL_HANDLER("top", vsfshell_top_handler),
+#endif
 	VSFSHELL_HANDLER_NONE
 };
 
@@ -56,14 +63,14 @@ static void vsfshell_streamrx_callback_on_in_int(void *p)
 {
 	struct vsfshell_t *shell = (struct vsfshell_t *)p;
 	
-	vsfsm_post_evt_pending(&shell->sm, VSFSHELL_EVT_STREAMRX_ONIN);
+	vsfsm_post_evt_coalesce(&shell->sm, VSFSHELL_EVT_STREAMRX_ONIN);
 }
 
 static void vsfshell_streamtx_callback_on_out_int(void *p)
 {
 	struct vsfshell_t *shell = (struct vsfshell_t *)p;
 	
-	vsfsm_post_evt_pending(&shell->sm, VSFSHELL_EVT_STREAMTX_ONOUT);
+	vsfsm_post_evt_coalesce(&shell->sm, VSFSHELL_EVT_STREAMTX_ONOUT);
 }
 
 static void vsfshell_streamrx_callback_on_txconn(void *p)
@@ -258,21 +265,19 @@ vsfshell_parse_cmd(char *cmd, struct vsfshell_handler_param_t *param)
 	return VSFERR_NONE;
 }
 
+static int vsfshell_handler_compare(struct vsf_rbtree_node_t *node,
+										const void *key)
+{
+	struct vsfshell_handler_t *handler =
+			vsf_rbtree_get_container(node, struct vsfshell_handler_t, node);
+	return strcmp(handler->name, (const char *)key);
+}
+
 static struct vsfshell_handler_t *
 vsfshell_search_handler(struct vsfshell_t *shell, char *name)
 {
-	struct vsfshell_handler_t *handler = shell->handlers;
-	
-	while (handler != NULL)
-	{
-		if (!strcmp(handler->name, name))
-		{
-			break;
-		}
-		handler = handler->next;
-	}
-	
-	return handler;
+	struct vsf_rbtree_node_t *node = vsf_rbtree_search(&shell->handlers, name);
+	return vsf_rbtree_get_container(node, struct vsfshell_handler_t, node);
 }
 
 static vsf_err_t
@@ -509,6 +514,16 @@ vsf_err_t vsfshell_init(struct vsfshell_t *shell)
 	// state machine init
 	shell->sm.init_state.evt_handler = vsfshell_evt_handler;
 	shell->sm.user_data = (void*)shell;
+	shell->handlers.compare = vsfshell_handler_compare;
+	vsf_rbtree_init(&shell->handlers);
+#if VSFSM_CFG_MAILBOX_EN
+	shell->mailbox.buffer = shell->mailbox_buffer;
+	shell->mailbox.size = dimof(shell->mailbox_buffer);
+	shell->sm.mailbox = &shell->mailbox;
+#endif
+#if VSFSM_CFG_PROFILE_EN
+	vsfsm_profile_register(&shell->sm, "shell");
+#endif
 	return vsfsm_init(&shell->sm);
 }
 
@@ -517,9 +532,8 @@ void vsfshell_register_handlers(struct vsfshell_t *shell,
 {
 	while ((handlers != NULL) && (handlers->name != NULL))
 	{
-		handlers->next = shell->handlers;
-		shell->handlers = handlers;
-		
+		// handler with duplicated name is ignored
+		vsf_rbtree_insert(&shell->handlers, &handlers->node, handlers->name);
 		handlers++;
 	}
 }
@@ -577,3 +591,92 @@ handler_thread_end:
 	
 	return VSFERR_NONE;
 }
+
+#if VSFSM_CFG_PROFILE_EN
+struct vsfshell_top_t
+{
+	uint32_t index;
+	struct vsfsm_profile_t profile;
+	struct vsfsm_evtq_status_t status;
+	struct vsftimer_stat_t timer_stat;
+};
+
+static vsf_err_t
+vsfshell_top_handler(struct vsfsm_pt_t *pt, vsfsm_evt_t evt)
+{
+	struct vsfshell_handler_param_t *param =
+						(struct vsfshell_handler_param_t *)pt->user_data;
+	struct vsfsm_pt_t *output_pt = &param->output_pt;
+	struct vsfshell_top_t *top = (struct vsfshell_top_t *)param->priv;
+	
+	vsfsm_pt_begin(pt);
+	if ((2 == param->argc) && !strcmp(param->argv[1], "reset"))
+	{
+		vsfsm_profile_reset();
+		vsftimer_reset_stat();
+		goto handler_thread_end;
+	}
+	else if (param->argc != 1)
+	{
+		vsfshell_printf(output_pt, "invalid format." VSFSHELL_LINEEND);
+		vsfshell_printf(output_pt, "format: top [reset]" VSFSHELL_LINEEND);
+		goto handler_thread_end;
+	}
+	
+	param->priv = MALLOC(sizeof(struct vsfshell_top_t));
+	if (NULL == param->priv)
+	{
+		vsfshell_printf(output_pt, "not enough resources." VSFSHELL_LINEEND);
+		goto handler_thread_end;
+	}
+	top = (struct vsfshell_top_t *)param->priv;
+	
+	// time is in the unit of VSFSM_CFG_PROFILE_GET_TIME
+	vsfshell_printf(output_pt,
+		"sm       evts     time     max_time pend drop" VSFSHELL_LINEEND);
+	for (top->index = 0; !vsfsm_profile_get(top->index, &top->profile);
+			top->index++)
+	{
+		vsfshell_printf(output_pt,
+			"%-8s %-8lu %-8lu %-8lu %-4lu %-4lu" VSFSHELL_LINEEND,
+			(top->profile.name != NULL) ? top->profile.name : "-",
+			(unsigned long)top->profile.dispatch_count,
+			(unsigned long)top->profile.total_time,
+			(unsigned long)top->profile.max_time,
+			(unsigned long)top->profile.max_evt_count,
+			(unsigned long)top->profile.drop_count);
+	}
+	
+	vsfshell_printf(output_pt,
+		"evtq     size     count    max      drop" VSFSHELL_LINEEND);
+	for (top->index = 0; !vsfsm_get_evtq_status(top->index, &top->status);
+			top->index++)
+	{
+		vsfshell_printf(output_pt,
+			"%-8lu %-8lu %-8lu %-8lu %-8lu" VSFSHELL_LINEEND,
+			(unsigned long)top->index,
+			(unsigned long)top->status.size,
+			(unsigned long)top->status.count,
+			(unsigned long)top->status.max_count,
+			(unsigned long)top->status.drop_count);
+	}
+	
+	vsftimer_get_stat(&top->timer_stat);
+	vsfshell_printf(output_pt,
+		"timer    wakeup   saved" VSFSHELL_LINEEND);
+	vsfshell_printf(output_pt,
+		"         %-8lu %-8lu" VSFSHELL_LINEEND,
+		(unsigned long)top->timer_stat.wakeup_count,
+		(unsigned long)top->timer_stat.wakeup_saved);
+	
+handler_thread_end:
+	if (param->priv != NULL)
+	{
+		FREE(param->priv);
+	}
+	vsfshell_handler_exit(pt);
+	vsfsm_pt_end(pt);
+	
+	return VSFERR_NONE;
+}
+#endif
@@ -22,14 +22,17 @@
 
 #include "dal/stream/stream.h"
 #include "framework/vsfsm/vsfsm.h"
+#include "tool/list/list.h"
 
-#define VSFSHELL_HANDLER(name, thread)		{(name), (thread), NULL}
+#define VSFSHELL_HANDLER(name, thread)		{(name), (thread)}
 #define VSFSHELL_HANDLER_NONE				VSFSHELL_HANDLER(NULL, NULL)
 struct vsfshell_handler_t
 {
 	const char * const name;
 	vsf_err_t (*thread)(struct vsfsm_pt_t *pt, vsfsm_evt_t evt);
-	struct vsfshell_handler_t *next;
+	
+	// private
+	struct vsf_rbtree_node_t node;
 };
 
 #define VSFSHELL_LINEEND					"\n\r"
@@ -49,12 +52,16 @@ struct vsfshell_t
 	struct vsf_transaction_buffer_t tbuffer;
 	struct vsfsm_t *input_sm;
 	struct vsfsm_t *output_sm;
-	struct vsfshell_handler_t *handlers;
+	struct vsf_rbtree_t handlers;
 	struct vsfsm_pt_t input_pt;
 	struct vsfsm_pt_t output_pt;
 	struct vsfsm_crit_t output_crit;
 	bool output_interrupted;
 	char ch;
+#if VSFSM_CFG_MAILBOX_EN
+	struct vsfsm_mailbox_t mailbox;
+	vsfsm_evt_t mailbox_buffer[8];
+#endif
 };
 
 struct vsfshell_handler_param_t
@@ -20,15 +20,91 @@
 #include "compiler.h"
 #include "vsfsm.h"
 
-struct vsfsm_evtqueue_t
+#if VSFSM_CFG_PROFILE_EN
+#include "interfaces.h"
+#endif
+#if VSFSM_CFG_SYNC_EN && VSFSM_CFG_SYNC_TIMEOUT_EN
+#include "framework/vsftimer/vsftimer.h"
+#endif
+
+struct vsfsm_evtq_element_t
 {
+#if VSFSM_CFG_EVTQ_LOCKFREE_EN
+	volatile uint32_t seq;
+#endif
 	struct vsfsm_t *sm;
 	vsfsm_evt_t evt;
 };
 
-static struct vsfsm_evtqueue_t vsfsm_evtq[VSFSM_CFG_EVTQ_SIZE];
-static struct vsfsm_evtqueue_t *vsfsm_evtq_head = &vsfsm_evtq[0];
-static volatile struct vsfsm_evtqueue_t *vsfsm_evtq_tail = &vsfsm_evtq[0];
+struct vsfsm_evtq_t
+{
+	struct vsfsm_evtq_element_t *queue;
+	uint32_t size;
+	
+#if VSFSM_CFG_EVTQ_LOCKFREE_EN
+	// head is only accessed by vsfsm_poll, tail is shared by the producers
+	uint32_t head;
+	volatile uint32_t tail;
+#else
+	struct vsfsm_evtq_element_t *head;
+	struct vsfsm_evtq_element_t * volatile tail;
+#endif
+	volatile uint32_t count;
+	uint32_t max_count;
+	uint32_t drop_count;
+	
+#if VSFSM_CFG_MAILBOX_EN
+	// list of sm with events pending in the mailbox
+	struct vsfsm_t *ready_head;
+	struct vsfsm_t *ready_tail;
+	// serve mailbox and queue alternately, so none of them can starve
+	bool mailbox_turn;
+#endif
+};
+
+#if VSFSM_CFG_EVTQ_LOCKFREE_EN
+#define VSFSM_EVTQ_INIT(buffer)			\
+	{(buffer), dimof(buffer), 0, 0, 0, 0, 0}
+#define VSFSM_EVTQ_SIZE_INVALID(size)	(((size) < 2) || ((size) & ((size) - 1)))
+#else
+#define VSFSM_EVTQ_INIT(buffer)			\
+	{(buffer), dimof(buffer), (buffer), (buffer), 0, 0, 0}
+#define VSFSM_EVTQ_SIZE_INVALID(size)	((size) < 1)
+#endif
+
+#if VSFSM_CFG_PRIORITY_EN
+#if VSFSM_EVTQ_SIZE_INVALID(VSFSM_CFG_EVTQ_LOW_SIZE) ||\
+	VSFSM_EVTQ_SIZE_INVALID(VSFSM_CFG_EVTQ_NORMAL_SIZE) ||\
+	VSFSM_EVTQ_SIZE_INVALID(VSFSM_CFG_EVTQ_HIGH_SIZE)
+#error "invalid event queue size"
+#endif
+
+#define VSFSM_EVTQ_NUM					VSFSM_PRIORITY_NUM
+static struct vsfsm_evtq_element_t
+			vsfsm_evtq_low_buffer[VSFSM_CFG_EVTQ_LOW_SIZE];
+static struct vsfsm_evtq_element_t
+			vsfsm_evtq_normal_buffer[VSFSM_CFG_EVTQ_NORMAL_SIZE];
+static struct vsfsm_evtq_element_t
+			vsfsm_evtq_high_buffer[VSFSM_CFG_EVTQ_HIGH_SIZE];
+// MUST be in the order of enum vsfsm_priority_t
+static struct vsfsm_evtq_t vsfsm_evtq[VSFSM_EVTQ_NUM] =
+{
+	VSFSM_EVTQ_INIT(vsfsm_evtq_low_buffer),
+	VSFSM_EVTQ_INIT(vsfsm_evtq_normal_buffer),
+	VSFSM_EVTQ_INIT(vsfsm_evtq_high_buffer),
+};
+#else
+#if VSFSM_EVTQ_SIZE_INVALID(VSFSM_CFG_EVTQ_SIZE)
+#error "invalid event queue size"
+#endif
+
+#define VSFSM_EVTQ_NUM					1
+static struct vsfsm_evtq_element_t vsfsm_evtq_buffer[VSFSM_CFG_EVTQ_SIZE];
+static struct vsfsm_evtq_t vsfsm_evtq[VSFSM_EVTQ_NUM] =
+{
+	VSFSM_EVTQ_INIT(vsfsm_evtq_buffer),
+};
+#endif
 static volatile uint32_t vsfsm_evt_count = 0;
 
 // vsfsm_get_event_pending should be called with interrupt disabled
@@ -37,20 +113,113 @@ uint32_t vsfsm_get_event_pending(void)
 	return vsfsm_evt_count;
 }
 
-static vsf_err_t vsfsm_evtq_post(struct vsfsm_t *sm, vsfsm_evt_t evt)
+#if VSFSM_CFG_EVTQ_LOCKFREE_EN
+// multi-producer single-consumer ring without critical sections
+// producers can be interrupt handlers of any priority preempting each other,
+// 		the only consumer is vsfsm_poll
+// seq of every element is relative to its index, so that a zero initialized
+// 		queue is valid, for the element at position pos:
+// 		seq == pos - index:		element is free for the producer
+// 		seq == pos - index + 1:	element is written, ready for the consumer
+static vsf_err_t vsfsm_evtq_post(struct vsfsm_evtq_t *evtq,
+									struct vsfsm_t *sm, vsfsm_evt_t evt)
+{
+	struct vsfsm_evtq_element_t *element;
+	uint32_t pos, index, count;
+	int32_t diff;
+	
+	pos = evtq->tail;
+	while (1)
+	{
+		index = pos & (evtq->size - 1);
+		element = &evtq->queue[index];
+		diff = (int32_t)(element->seq - (pos - index));
+		if (0 == diff)
+		{
+			if (vsf_atomic_cas(&evtq->tail, pos, pos + 1))
+			{
+				break;
+			}
+			pos = evtq->tail;
+		}
+		else if (diff < 0)
+		{
+			// element still holds the event of the previous round
+			return VSFERR_NOT_ENOUGH_RESOURCES;
+		}
+		else
+		{
+			// element is taken by another producer
+			pos = evtq->tail;
+		}
+	}
+	
+	// sm->evt_count is increased before the element is ready,
+	// 		so it will never underflow in vsfsm_poll
+	vsf_atomic_add(&sm->evt_count, 1);
+	element->sm = sm;
+	element->evt = evt;
+	vsf_barrier();
+	element->seq = pos - index + 1;
+	
+	count = vsf_atomic_add(&evtq->count, 1);
+	// max_count is only for statistics, a lost update is acceptable
+	if (count > evtq->max_count)
+	{
+		evtq->max_count = count;
+	}
+	vsf_atomic_add(&vsfsm_evt_count, 1);
+	return VSFERR_NONE;
+}
+
+// get the element at head, return NULL if the element is not ready,
+// which means the producer is preempted before finishing the post
+static struct vsfsm_evtq_element_t *
+vsfsm_evtq_peek(struct vsfsm_evtq_t *evtq)
+{
+	uint32_t index = evtq->head & (evtq->size - 1);
+	struct vsfsm_evtq_element_t *element = &evtq->queue[index];
+	
+	if (element->seq != evtq->head - index + 1)
+	{
+		return NULL;
+	}
+	vsf_barrier();
+	return element;
+}
+
+// free the element at head after the event is dispatched to sm
+static void vsfsm_evtq_free(struct vsfsm_evtq_t *evtq, struct vsfsm_t *sm)
+{
+	uint32_t index = evtq->head & (evtq->size - 1);
+	
+	vsf_atomic_add(&sm->evt_count, (uint32_t)-1);
+	vsf_atomic_add(&vsfsm_evt_count, (uint32_t)-1);
+	vsf_atomic_add(&evtq->count, (uint32_t)-1);
+	vsf_barrier();
+	evtq->queue[index].seq = evtq->head + evtq->size - index;
+	evtq->head++;
+}
+#else
+static vsf_err_t vsfsm_evtq_post(struct vsfsm_evtq_t *evtq,
+									struct vsfsm_t *sm, vsfsm_evt_t evt)
 {
 	vsf_enter_critical();
 	
-	if (vsfsm_evt_count >= VSFSM_CFG_EVTQ_SIZE)
+	if (evtq->count >= evtq->size)
 	{
 		vsf_leave_critical();
 		return VSFERR_NOT_ENOUGH_RESOURCES;
 	}
 	
-	vsfsm_evtq_tail->sm = sm;
-	vsfsm_evtq_tail->evt = evt;
-	(vsfsm_evtq_tail == &vsfsm_evtq[VSFSM_CFG_EVTQ_SIZE - 1]) ?
-		vsfsm_evtq_tail = &vsfsm_evtq[0] : vsfsm_evtq_tail++;
+	evtq->tail->sm = sm;
+	evtq->tail->evt = evt;
+	(evtq->tail == &evtq->queue[evtq->size - 1]) ?
+		evtq->tail = &evtq->queue[0] : evtq->tail++;
+	if (++evtq->count > evtq->max_count)
+	{
+		evtq->max_count = evtq->count;
+	}
 	sm->evt_count++;
 	vsfsm_evt_count++;
 	
@@ -59,28 +228,131 @@ static vsf_err_t vsfsm_evtq_post(struct vsfsm_t *sm, vsfsm_evt_t evt)
 	return VSFERR_NONE;
 }
 
+#define vsfsm_evtq_peek(evtq)			(evtq)->head
+
+static void vsfsm_evtq_free(struct vsfsm_evtq_t *evtq, struct vsfsm_t *sm)
+{
+	(evtq->head == &evtq->queue[evtq->size - 1]) ?
+		evtq->head = &evtq->queue[0] : evtq->head++;
+	vsf_enter_critical();
+	sm->evt_count--;
+	evtq->count--;
+	vsfsm_evt_count--;
+	vsf_leave_critical();
+}
+#endif
+
 #if VSFSM_CFG_SM_EN && VSFSM_CFG_HSM_EN
-static bool vsfsm_is_in(struct vsfsm_state_t *s, struct vsfsm_state_t *t)
+// transition path from source to target:
+// 		exit from source to lca(not included), and enter from lca(not included)
+// 		to target, enter is in the order of entering
+struct vsfsm_hsm_path_t
+{
+	struct vsfsm_state_t *source;
+	struct vsfsm_state_t *target;
+	struct vsfsm_state_t *lca;
+	uint32_t enter_num;
+	struct vsfsm_state_t *enter[VSFSM_CFG_HSM_MAX_DEPTH];
+};
+static struct vsfsm_hsm_path_t
+			vsfsm_hsm_path_cache[VSFSM_CFG_HSM_PATH_CACHE_SIZE];
+static uint32_t vsfsm_hsm_path_cache_pos;
+
+static uint32_t vsfsm_hsm_get_depth(struct vsfsm_state_t *state)
+{
+	uint32_t depth = 0;
+	
+	while (state != NULL)
+	{
+		depth++;
+		state = state->super;
+	}
+	return depth;
+}
+
+// find the path from the cache, or calculate and cache it
+// LCA is found in O(depth) by aligning the depth of source and target
+static struct vsfsm_hsm_path_t *
+vsfsm_hsm_get_path(struct vsfsm_state_t *source, struct vsfsm_state_t *target)
 {
-	while (t != NULL)
+	struct vsfsm_hsm_path_t *path;
+	struct vsfsm_state_t *s, *t;
+	uint32_t i, source_depth, target_depth;
+	
+	for (i = 0; i < dimof(vsfsm_hsm_path_cache); i++)
 	{
-		if (s == t)
+		path = &vsfsm_hsm_path_cache[i];
+		if ((path->source == source) && (path->target == target))
 		{
-			return true;
+			return path;
 		}
+	}
+	
+	source_depth = vsfsm_hsm_get_depth(source);
+	target_depth = vsfsm_hsm_get_depth(target);
+	if (target_depth > VSFSM_CFG_HSM_MAX_DEPTH)
+	{
+		return NULL;
+	}
+	
+	// replace the cached paths in round robin
+	path = &vsfsm_hsm_path_cache[vsfsm_hsm_path_cache_pos];
+	if (++vsfsm_hsm_path_cache_pos >= dimof(vsfsm_hsm_path_cache))
+	{
+		vsfsm_hsm_path_cache_pos = 0;
+	}
+	
+	s = source;
+	t = target;
+	// transition to self will exit and re-enter the state
+	if (source == target)
+	{
+		s = s->super;
+		t = t->super;
+		source_depth--;
+		target_depth--;
+	}
+	while (source_depth > target_depth)
+	{
+		s = s->super;
+		source_depth--;
+	}
+	while (target_depth > source_depth)
+	{
 		t = t->super;
+		target_depth--;
 	}
-	return false;
+	while (s != t)
+	{
+		s = s->super;
+		t = t->super;
+	}
+	
+	// s and t are the lca, NULL if source and target are not in the same tree
+	path->source = source;
+	path->target = target;
+	path->lca = s;
+	path->enter_num = 0;
+	for (t = target; t != path->lca; t = t->super)
+	{
+		path->enter_num++;
+	}
+	for (i = path->enter_num, t = target; i > 0; t = t->super)
+	{
+		path->enter[--i] = t;
+	}
+	return path;
 }
 #endif
 
-static vsf_err_t vsfsm_dispatch_evt(struct vsfsm_t *sm, vsfsm_evt_t evt)
+static vsf_err_t vsfsm_dispatch_evt_do(struct vsfsm_t *sm, vsfsm_evt_t evt)
 {
 #if VSFSM_CFG_SM_EN && VSFSM_CFG_HSM_EN
-	struct vsfsm_state_t *temp_state = NULL, *lca_state;
-	struct vsfsm_state_t *temp_processor_state, *temp_target_state;
+	struct vsfsm_hsm_path_t *path;
+	struct vsfsm_state_t *temp_state;
 	struct vsfsm_state_t *processor_state = sm->cur_state;
 	struct vsfsm_state_t *target_state = processor_state->evt_handler(sm, evt);
+	uint32_t i;
 #elif VSFSM_CFG_SM_EN
 	struct vsfsm_state_t *target_state = sm->cur_state->evt_handler(sm, evt);
 #else
@@ -100,11 +372,13 @@ static vsf_err_t vsfsm_dispatch_evt(struct vsfsm_t *sm, vsfsm_evt_t evt)
 	// superstate
 	while (target_state == (struct vsfsm_state_t *)-1)
 	{
-		processor_state = sm->cur_state->super;
-		if (processor_state != NULL)
+		processor_state = processor_state->super;
+		if (NULL == processor_state)
 		{
-			target_state = processor_state->evt_handler(sm, evt);
+			// even topstate can not handle this event
+			return VSFERR_NONE;
 		}
+		target_state = processor_state->evt_handler(sm, evt);
 	}
 #endif
 	
@@ -144,46 +418,22 @@ static vsf_err_t vsfsm_dispatch_evt(struct vsfsm_t *sm, vsfsm_evt_t evt)
 		target_state->evt_handler(sm, VSFSM_EVT_ENTER);
 		goto update_cur_state;
 	}
-	// 3. find the LCA
-	lca_state = NULL;
-	temp_processor_state = processor_state;
-	temp_target_state = target_state;
-	do
+	// 3. get the cached path
+	path = vsfsm_hsm_get_path(processor_state, target_state);
+	if ((NULL == path) || (NULL == path->lca))
 	{
-		if (temp_processor_state != NULL)
-		{
-			if (vsfsm_is_in(temp_processor_state, target_state))
-			{
-				lca_state = temp_processor_state;
-				break;
-			}
-			temp_processor_state = temp_processor_state->super;
-		}
-		if (temp_target_state != NULL)
-		{
-			if (vsfsm_is_in(temp_target_state, processor_state))
-			{
-				lca_state = temp_target_state;
-				break;
-			}
-			temp_target_state = temp_target_state->super;
-		}
-		if ((NULL == temp_processor_state) && (NULL == temp_target_state))
-		{
-			return VSFERR_BUG;
-		}
-	} while (NULL == lca_state);
+		return VSFERR_BUG;
+	}
 	// 4. exit from processor_state to lca
-	for (temp_state = processor_state; temp_state != lca_state;)
+	for (temp_state = processor_state; temp_state != path->lca;)
 	{
 		temp_state->evt_handler(sm, VSFSM_EVT_EXIT);
 		temp_state = temp_state->super;
 	}
 	// 5. enter from lca to target_state
-	for (temp_state = lca_state; temp_state != target_state;)
+	for (i = 0; i < path->enter_num; i++)
 	{
-		temp_state->evt_handler(sm, VSFSM_EVT_ENTER);
-		temp_state = temp_state->super;
+		path->enter[i]->evt_handler(sm, VSFSM_EVT_ENTER);
 	}
 	// 6. update cur_state
 update_cur_state:
@@ -198,6 +448,105 @@ update_cur_state:
 #endif
 }
 
+#if VSFSM_CFG_PROFILE_EN
+static struct vsfsm_t *vsfsm_profile_list = NULL;
+// time of the nested dispatches in current dispatch
+static uint32_t vsfsm_profile_nested_time = 0;
+
+static vsf_err_t vsfsm_dispatch_evt(struct vsfsm_t *sm, vsfsm_evt_t evt)
+{
+	uint32_t start_time, time, nested_time = vsfsm_profile_nested_time;
+	vsf_err_t err;
+	
+	vsfsm_profile_nested_time = 0;
+	start_time = VSFSM_CFG_PROFILE_GET_TIME();
+	err = vsfsm_dispatch_evt_do(sm, evt);
+	time = VSFSM_CFG_PROFILE_GET_TIME() - start_time;
+	
+	// events dispatched directly by the handler are not counted in the sm
+	sm->profile.dispatch_count++;
+	sm->profile.total_time += time - vsfsm_profile_nested_time;
+	if ((time - vsfsm_profile_nested_time) > sm->profile.max_time)
+	{
+		sm->profile.max_time = time - vsfsm_profile_nested_time;
+	}
+	vsfsm_profile_nested_time = nested_time + time;
+	return err;
+}
+
+vsf_err_t vsfsm_profile_register(struct vsfsm_t *sm, const char *name)
+{
+	struct vsfsm_t *sm_temp = vsfsm_profile_list;
+	
+	while (sm_temp != NULL)
+	{
+		if (sm_temp == sm)
+		{
+			break;
+		}
+		sm_temp = sm_temp->profile.next;
+	}
+	
+	if (NULL == sm_temp)
+	{
+		sm_temp = vsfsm_profile_list;
+		vsfsm_profile_list = sm;
+	}
+	else
+	{
+		// already registered, keep the list
+		sm_temp = sm->profile.next;
+	}
+	memset(&sm->profile, 0, sizeof(sm->profile));
+	sm->profile.name = name;
+	sm->profile.next = sm_temp;
+	return VSFERR_NONE;
+}
+
+vsf_err_t vsfsm_profile_unregister(struct vsfsm_t *sm)
+{
+	struct vsfsm_t *sm_temp = vsfsm_profile_list;
+	
+	if (sm == vsfsm_profile_list)
+	{
+		vsfsm_profile_list = sm->profile.next;
+		return VSFERR_NONE;
+	}
+	while (sm_temp != NULL)
+	{
+		if (sm_temp->profile.next == sm)
+		{
+			sm_temp->profile.next = sm->profile.next;
+			return VSFERR_NONE;
+		}
+		sm_temp = sm_temp->profile.next;
+	}
+	return VSFERR_FAIL;
+}
+
+vsf_err_t vsfsm_profile_get(uint32_t index, struct vsfsm_profile_t *profile)
+{
+	struct vsfsm_t *sm = vsfsm_profile_list;
+	
+	while ((sm != NULL) && index--)
+	{
+		sm = sm->profile.next;
+	}
+	if (NULL == sm)
+	{
+		return VSFERR_FAIL;
+	}
+	
+	// drop_count and max_evt_count can be updated in interrupt
+	vsf_enter_critical();
+	*profile = sm->profile;
+	vsf_leave_critical();
+	return VSFERR_NONE;
+}
+#else
+#define vsfsm_dispatch_evt(sm, evt)		vsfsm_dispatch_evt_do((sm), (evt))
+#endif
+
 #if VSFSM_CFG_HSM_EN
 static struct vsfsm_state_t *
 vsfsm_top_handler(struct vsfsm_t *sm, vsfsm_evt_t evt)
@@ -210,65 +559,194 @@ struct vsfsm_state_t vsfsm_top = {vsfsm_top_handler};
 #endif
 
 #if (VSFSM_CFG_SM_EN && VSFSM_CFG_SUBSM_EN) || VSFSM_CFG_HSM_EN
-static bool vsfsm_subsm_exists(struct vsfsm_state_t *state, struct vsfsm_t *sm)
+vsf_err_t vsfsm_add_subsm(struct vsfsm_state_t *state, struct vsfsm_t *sm)
 {
-	struct vsfsm_t *sm_temp = state->subsm;
-	while (sm_temp != NULL)
+	if (!vsf_hlist_is_linked(&sm->subsm_node))
 	{
-		if (sm_temp == sm)
-		{
-			return true;
-		}
-		sm_temp = sm_temp->next;
+		vsf_hlist_add_head(&state->subsm, &sm->subsm_node);
 	}
-	return false;
+	return VSFERR_NONE;
 }
 
-vsf_err_t vsfsm_add_subsm(struct vsfsm_state_t *state, struct vsfsm_t *sm)
+vsf_err_t vsfsm_remove_subsm(struct vsfsm_state_t *state, struct vsfsm_t *sm)
 {
-	if (!vsfsm_subsm_exists(state, sm))
+	REFERENCE_PARAMETER(state);
+	if (vsf_hlist_is_linked(&sm->subsm_node))
 	{
-		if (NULL == state->subsm)
-		{
-			sm->next = NULL;
-		}
-		else
-		{
-			sm->next = state->subsm;
-		}
-		state->subsm = sm;
+		vsf_hlist_remove(&sm->subsm_node);
 	}
 	return VSFERR_NONE;
 }
+#endif
 
-vsf_err_t vsfsm_remove_subsm(struct vsfsm_state_t *state, struct vsfsm_t *sm)
+#if VSFSM_CFG_MAILBOX_EN
+// mailbox is protected by critical section, even if lock-free event queue is
+// 		enabled, because the sm linked in the ready list is shared
+#if VSFSM_CFG_EVTQ_LOCKFREE_EN
+#define vsfsm_counter_add(counter, n)	vsf_atomic_add(&(counter), (n))
+#else
+#define vsfsm_counter_add(counter, n)	((counter) += (n))
+#endif
+
+static void vsfsm_mailbox_ready(struct vsfsm_evtq_t *evtq, struct vsfsm_t *sm)
 {
-	struct vsfsm_t *sm_temp = state->subsm;
-	if (sm_temp == sm)
+	sm->mailbox->ready_next = NULL;
+	if (NULL == evtq->ready_head)
 	{
-		state->subsm = sm->next;
+		evtq->ready_head = sm;
 	}
 	else
 	{
-		while (sm_temp != NULL)
+		evtq->ready_tail->mailbox->ready_next = sm;
+	}
+	evtq->ready_tail = sm;
+}
+
+static vsf_err_t vsfsm_mailbox_post(struct vsfsm_evtq_t *evtq,
+					struct vsfsm_t *sm, vsfsm_evt_t evt, bool coalesce)
+{
+	struct vsfsm_mailbox_t *mailbox = sm->mailbox;
+	uint32_t i, pos;
+	
+	vsf_enter_critical();
+	
+	if (coalesce)
+	{
+		for (i = 0, pos = mailbox->head; i < mailbox->count; i++)
 		{
-			if (sm_temp->next == sm)
+			if (mailbox->buffer[pos] == evt)
 			{
-				sm_temp->next = sm->next;
-				break;
+				// same event is already pending
+				vsf_leave_critical();
+				return VSFERR_NONE;
 			}
-			sm_temp = sm_temp->next;
+			pos = (pos == mailbox->size - 1) ? 0 : pos + 1;
 		}
 	}
+	
+	if (mailbox->count >= mailbox->size)
+	{
+		vsf_leave_critical();
+		return VSFERR_NOT_ENOUGH_RESOURCES;
+	}
+	
+	pos = mailbox->head + mailbox->count;
+	if (pos >= mailbox->size)
+	{
+		pos -= mailbox->size;
+	}
+	mailbox->buffer[pos] = evt;
+	mailbox->count++;
+	// if the sm is ready, it's either in the ready list, or being dispatched
+	// 		and will be put back to the ready list by vsfsm_mailbox_dispatch
+	if (!mailbox->ready)
+	{
+		mailbox->ready = true;
+		vsfsm_mailbox_ready(evtq, sm);
+	}
+	vsfsm_counter_add(sm->evt_count, 1);
+	vsfsm_counter_add(vsfsm_evt_count, 1);
+	
+	vsf_leave_critical();
+	
 	return VSFERR_NONE;
 }
+
+// dispatch one event of the first sm in the ready list,
+// 		and move the sm to the tail of the ready list if more events pending
+static void vsfsm_mailbox_dispatch(struct vsfsm_evtq_t *evtq)
+{
+	struct vsfsm_t *sm;
+	struct vsfsm_mailbox_t *mailbox;
+	vsfsm_evt_t evt;
+	
+	// remove the event from mailbox before dispatching, so that the same
+	// 		event posted while dispatching will not be coalesced
+	vsf_enter_critical();
+	sm = evtq->ready_head;
+	mailbox = sm->mailbox;
+	evtq->ready_head = mailbox->ready_next;
+	evt = mailbox->buffer[mailbox->head];
+	mailbox->head = (mailbox->head == mailbox->size - 1) ? 0 :
+						mailbox->head + 1;
+	mailbox->count--;
+	vsf_leave_critical();
+	
+	vsfsm_dispatch_evt(sm, evt);
+	
+	vsf_enter_critical();
+	if (mailbox->count)
+	{
+		vsfsm_mailbox_ready(evtq, sm);
+	}
+	else
+	{
+		mailbox->ready = false;
+	}
+	vsfsm_counter_add(sm->evt_count, (uint32_t)-1);
+	vsfsm_counter_add(vsfsm_evt_count, (uint32_t)-1);
+	vsf_leave_critical();
+}
+
+#define vsfsm_evtq_pending(evtq)		\
+	((evtq)->count || ((evtq)->ready_head != NULL))
+#else
+#define vsfsm_evtq_pending(evtq)		((evtq)->count)
+#endif
+
+static vsf_err_t vsfsm_post_sm(struct vsfsm_evtq_t *evtq, struct vsfsm_t *sm,
+								vsfsm_evt_t evt, bool coalesce)
+{
+	vsf_err_t err;
+	
+#if VSFSM_CFG_MAILBOX_EN
+	if (sm->mailbox != NULL)
+	{
+		err = vsfsm_mailbox_post(evtq, sm, evt, coalesce);
+	}
+	else
+#else
+	REFERENCE_PARAMETER(coalesce);
+#endif
+	{
+		err = vsfsm_evtq_post(evtq, sm, evt);
+		if (err)
+		{
+			// statistics only, not protected
+			evtq->drop_count++;
+		}
+	}
+	
+#if VSFSM_CFG_PROFILE_EN
+	if (err)
+	{
+		sm->profile.drop_count++;
+	}
+	else if (sm->evt_count > sm->profile.max_evt_count)
+	{
+		sm->profile.max_evt_count = sm->evt_count;
+	}
 #endif
+	return err;
+}
 
 vsf_err_t vsfsm_init(struct vsfsm_t *sm)
 {
 	sm->evt_count = 0;
 #if VSFSM_CFG_SYNC_EN
-	sm->pending_next = NULL;
+	vsf_dlist_init_node(&sm->pending_node);
+	sm->pending_list = NULL;
+#if VSFSM_CFG_SYNC_TIMEOUT_EN
+	sm->pending_timer = NULL;
+#endif
+#endif
+#if VSFSM_CFG_MAILBOX_EN
+	if (sm->mailbox != NULL)
+	{
+		sm->mailbox->head = 0;
+		sm->mailbox->count = 0;
+		sm->mailbox->ready = false;
+	}
 #endif
 #if VSFSM_CFG_SM_EN || VSFSM_CFG_HSM_EN
 	sm->cur_state = &sm->init_state;
@@ -285,18 +763,43 @@ vsf_err_t vsfsm_init(struct vsfsm_t *sm)
 
 vsf_err_t vsfsm_poll(void)
 {
+	struct vsfsm_evtq_t *evtq;
+	struct vsfsm_evtq_element_t *element;
 	struct vsfsm_t *sm;
 	
 	while (vsfsm_evt_count)
 	{
-		sm = vsfsm_evtq_head->sm;
-		vsfsm_dispatch_evt(sm, vsfsm_evtq_head->evt);
-		(vsfsm_evtq_head == &vsfsm_evtq[VSFSM_CFG_EVTQ_SIZE - 1]) ?
-			vsfsm_evtq_head = &vsfsm_evtq[0] : vsfsm_evtq_head++;
-		vsf_enter_critical();
-		sm->evt_count--;
-		vsfsm_evt_count--;
-		vsf_leave_critical();
+		// always process the highest priority queue which has pending events,
+		// so that events posted by the handler with higher priority will be
+		// processed before the remaining lower priority events
+		evtq = &vsfsm_evtq[VSFSM_EVTQ_NUM - 1];
+		while (!vsfsm_evtq_pending(evtq))
+		{
+			if (evtq == &vsfsm_evtq[0])
+			{
+				return VSFERR_NOT_READY;
+			}
+			evtq--;
+		}
+		
+#if VSFSM_CFG_MAILBOX_EN
+		if ((evtq->ready_head != NULL) &&
+			(!evtq->count || evtq->mailbox_turn))
+		{
+			evtq->mailbox_turn = false;
+			vsfsm_mailbox_dispatch(evtq);
+			continue;
+		}
+		evtq->mailbox_turn = true;
+#endif
+		element = vsfsm_evtq_peek(evtq);
+		if (NULL == element)
+		{
+			return VSFERR_NOT_READY;
+		}
+		sm = element->sm;
+		vsfsm_dispatch_evt(sm, element->evt);
+		vsfsm_evtq_free(evtq, sm);
 	}
 	return VSFERR_NONE;
 }
@@ -311,7 +814,17 @@ vsf_err_t vsfsm_set_active(struct vsfsm_t *sm, bool active)
 }
 #endif
 
+#if VSFSM_CFG_PRIORITY_EN
+#define vsfsm_get_evtq(priority)		\
+	&vsfsm_evtq[min((priority), VSFSM_EVTQ_NUM - 1)]
+
+vsf_err_t vsfsm_post_evt_prio(struct vsfsm_t *sm, vsfsm_evt_t evt,
+								uint8_t priority)
+#else
+#define vsfsm_get_evtq(priority)		&vsfsm_evtq[0]
+
 vsf_err_t vsfsm_post_evt(struct vsfsm_t *sm, vsfsm_evt_t evt)
+#endif
 {
 	return
 #if VSFSM_CFG_ACTIVE_EN
@@ -322,11 +835,34 @@ vsf_err_t vsfsm_post_evt(struct vsfsm_t *sm, vsfsm_evt_t evt)
 			((evt >= VSFSM_EVT_LOCAL_INSTANT) &&
 				(evt <= VSFSM_EVT_LOCAL_INSTANT_END)) ||
 			(0 == sm->evt_count) ?
-				vsfsm_dispatch_evt(sm, evt) : vsfsm_evtq_post(sm, evt);
+				vsfsm_dispatch_evt(sm, evt) :
+				vsfsm_post_sm(vsfsm_get_evtq(priority), sm, evt, false);
 }
 
 // pending event will be forced to be sent to event queue
+#if VSFSM_CFG_PRIORITY_EN
+vsf_err_t vsfsm_post_evt_pending_prio(struct vsfsm_t *sm, vsfsm_evt_t evt,
+								uint8_t priority)
+#else
 vsf_err_t vsfsm_post_evt_pending(struct vsfsm_t *sm, vsfsm_evt_t evt)
+#endif
+{
+	return
+#if VSFSM_CFG_ACTIVE_EN
+			(!sm->active) ||
+#endif
+			((evt >= VSFSM_EVT_INSTANT) &&
+				(evt <= VSFSM_EVT_INSTANT_END)) ||
+			((evt >= VSFSM_EVT_LOCAL_INSTANT) &&
+				(evt <= VSFSM_EVT_LOCAL_INSTANT_END)) ?
+				VSFERR_FAIL :
+				vsfsm_post_sm(vsfsm_get_evtq(priority), sm, evt, false);
+}
+
+#if VSFSM_CFG_MAILBOX_EN
+// same as vsfsm_post_evt_pending, but the event will be ignored if the same
+// 		event is already pending in the mailbox of the sm
+vsf_err_t vsfsm_post_evt_coalesce(struct vsfsm_t *sm, vsfsm_evt_t evt)
 {
 	return
 #if VSFSM_CFG_ACTIVE_EN
@@ -336,8 +872,71 @@ vsf_err_t vsfsm_post_evt_pending(struct vsfsm_t *sm, vsfsm_evt_t evt)
 				(evt <= VSFSM_EVT_INSTANT_END)) ||
 			((evt >= VSFSM_EVT_LOCAL_INSTANT) &&
 				(evt <= VSFSM_EVT_LOCAL_INSTANT_END)) ?
-				VSFERR_FAIL : vsfsm_evtq_post(sm, evt);
+				VSFERR_FAIL :
+#if VSFSM_CFG_PRIORITY_EN
+				vsfsm_post_sm(vsfsm_get_evtq(sm->priority), sm, evt, true);
+#else
+				vsfsm_post_sm(vsfsm_get_evtq(0), sm, evt, true);
+#endif
+}
+#endif
+
+#if VSFSM_CFG_PRIORITY_EN
+vsf_err_t vsfsm_post_evt(struct vsfsm_t *sm, vsfsm_evt_t evt)
+{
+	return vsfsm_post_evt_prio(sm, evt, sm->priority);
+}
+
+vsf_err_t vsfsm_post_evt_pending(struct vsfsm_t *sm, vsfsm_evt_t evt)
+{
+	return vsfsm_post_evt_pending_prio(sm, evt, sm->priority);
 }
+#endif
+
+vsf_err_t vsfsm_get_evtq_status(uint8_t priority,
+								struct vsfsm_evtq_status_t *status)
+{
+	struct vsfsm_evtq_t *evtq;
+	
+	if (priority >= VSFSM_EVTQ_NUM)
+	{
+		return VSFERR_INVALID_PARAMETER;
+	}
+	
+	evtq = &vsfsm_evtq[priority];
+	vsf_enter_critical();
+	status->size = evtq->size;
+	status->count = evtq->count;
+	status->max_count = evtq->max_count;
+	status->drop_count = evtq->drop_count;
+	vsf_leave_critical();
+	return VSFERR_NONE;
+}
+
+#if VSFSM_CFG_PROFILE_EN
+void vsfsm_profile_reset(void)
+{
+	struct vsfsm_t *sm = vsfsm_profile_list;
+	uint32_t i;
+	
+	vsf_enter_critical();
+	while (sm != NULL)
+	{
+		sm->profile.dispatch_count = 0;
+		sm->profile.total_time = 0;
+		sm->profile.max_time = 0;
+		sm->profile.max_evt_count = 0;
+		sm->profile.drop_count = 0;
+		sm = sm->profile.next;
+	}
+	for (i = 0; i < VSFSM_EVTQ_NUM; i++)
+	{
+		vsfsm_evtq[i].max_count = vsfsm_evtq[i].count;
+		vsfsm_evtq[i].drop_count = 0;
+	}
+	vsf_leave_critical();
+}
+#endif
 
 #if VSFSM_CFG_PT_EN
 #include "interfaces.h"
@@ -385,78 +984,315 @@ vsf_err_t vsfsm_pt_init(struct vsfsm_t *sm, struct vsfsm_pt_t *pt)
 	sm->user_data = pt;
 	sm->init_state.evt_handler = vsfsm_pt_evt_handler;
 #if (VSFSM_CFG_SM_EN && VSFSM_CFG_SUBSM_EN) || VSFSM_CFG_HSM_EN
-	sm->init_state.subsm = NULL;
+	vsf_hlist_init(&sm->init_state.subsm);
 #endif
 	pt->sm = sm;
 	return vsfsm_init(sm);
 }
 #endif
 
-#if VSFSM_CFG_SYNC_EN
-// vsfsm_sync_t
-vsf_err_t vsfsm_sync_init(struct vsfsm_sync_t *sync, uint32_t cur_value,
-				uint32_t max_value, vsfsm_evt_t evt)
+#if VSFSM_CFG_THREAD_EN
+#define VSFSM_THREAD_STACK_MAGIC		0xDEADBEEF
+
+#if VSFSM_CFG_THREAD_STACK_NUM > 0
+static uint32_t vsfsm_thread_stack_pool[VSFSM_CFG_THREAD_STACK_NUM]
+							[VSFSM_CFG_THREAD_STACK_SIZE / sizeof(uint32_t)];
+static uint32_t vsfsm_thread_stack_mask;
+#endif
+// thread to run, used by vsfsm_thread_entry when the thread starts
+static struct vsfsm_thread_t *vsfsm_thread_cur;
+
+static void vsfsm_thread_entry(void);
+
+#if defined(__ICCARM__) || defined(__arm__)
+// callee-saved registers are pushed to the stack of the current context,
+// 		and popped from the stack of the next context
+#if defined(__ARMVFP__) || defined(__ARM_FP)
+#define VSFSM_THREAD_FRAME_SIZE			25
+#define VSFSM_THREAD_SAVE				"push {r4-r11, lr}\n vpush {s16-s31}\n"
+#define VSFSM_THREAD_RESTORE			"vpop {s16-s31}\n pop {r4-r11, pc}\n"
+#else
+#define VSFSM_THREAD_FRAME_SIZE			9
+#define VSFSM_THREAD_SAVE				"push {r4-r11, lr}\n"
+#define VSFSM_THREAD_RESTORE			"pop {r4-r11, pc}\n"
+#endif
+
+#if defined(__ICCARM__)
+static __stackless void
+#else
+__attribute__((naked)) static void
+#endif
+vsfsm_thread_swap(vsfsm_thread_context_t *cur, vsfsm_thread_context_t *next)
 {
-	sync->cur_value = cur_value;
-	sync->max_value = max_value;
-	sync->sm_pending = NULL;
-	return VSFERR_NONE;
+	__asm volatile(
+		VSFSM_THREAD_SAVE
+		"str sp, [r0]\n"
+		"ldr r2, [r1]\n"
+		"mov sp, r2\n"
+		VSFSM_THREAD_RESTORE
+	);
 }
 
-static void vsfsm_sync_append_sm(struct vsfsm_t *sm, struct vsfsm_sync_t *sync)
+static void vsfsm_thread_context_init(struct vsfsm_thread_t *thread)
 {
-	struct vsfsm_t *sm_pending;
+	uint32_t *sp = thread->stack + thread->stack_size / sizeof(uint32_t);
 	
-	sm->pending_next = NULL;
-	if (NULL == sync->sm_pending)
+	// stack MUST be 8-byte aligned when entering vsfsm_thread_entry
+	sp = (uint32_t *)((uint32_t)sp & ~7);
+	sp -= VSFSM_THREAD_FRAME_SIZE;
+	// popped to pc by vsfsm_thread_swap
+	sp[VSFSM_THREAD_FRAME_SIZE - 1] = (uint32_t)vsfsm_thread_entry;
+	thread->context = (uint32_t)sp;
+}
+#else
+#define vsfsm_thread_swap(cur, next)	swapcontext((cur), (next))
+
+static void vsfsm_thread_context_init(struct vsfsm_thread_t *thread)
+{
+	getcontext(&thread->context);
+	thread->context.uc_stack.ss_sp = thread->stack;
+	thread->context.uc_stack.ss_size = thread->stack_size;
+	thread->context.uc_link = NULL;
+	makecontext(&thread->context, vsfsm_thread_entry, 0);
+}
+#endif
+
+static uint32_t *vsfsm_thread_alloc_stack(void)
+{
+#if VSFSM_CFG_THREAD_STACK_NUM > 0
+	uint32_t i;
+	
+	for (i = 0; i < VSFSM_CFG_THREAD_STACK_NUM; i++)
 	{
-		sync->sm_pending = sm;
+		if (!(vsfsm_thread_stack_mask & (1 << i)))
+		{
+			vsfsm_thread_stack_mask |= 1 << i;
+			return vsfsm_thread_stack_pool[i];
+		}
 	}
-	else
+#endif
+	return NULL;
+}
+
+static void vsfsm_thread_free_stack(uint32_t *stack)
+{
+#if VSFSM_CFG_THREAD_STACK_NUM > 0
+	uint32_t i;
+	
+	for (i = 0; i < VSFSM_CFG_THREAD_STACK_NUM; i++)
 	{
-		sm_pending = sync->sm_pending;
-		while (sm_pending->pending_next != NULL)
+		if (stack == vsfsm_thread_stack_pool[i])
 		{
-			sm_pending = sm_pending->pending_next;
+			vsfsm_thread_stack_mask &= ~(1 << i);
+			break;
 		}
-		sm_pending->pending_next = sm;
 	}
+#endif
 }
 
-vsf_err_t vsfsm_sync_cancel(struct vsfsm_t *sm, struct vsfsm_sync_t *sync)
+// stack grows downwards, the high-water mark is the lowest word which is
+// 		not VSFSM_THREAD_STACK_MAGIC
+static uint32_t vsfsm_thread_calc_stack_usage(struct vsfsm_thread_t *thread)
+{
+	uint32_t i, num = thread->stack_size / sizeof(uint32_t);
+	
+	for (i = 0; (i < num) && (VSFSM_THREAD_STACK_MAGIC == thread->stack[i]);
+			i++);
+	return (num - i) * sizeof(uint32_t);
+}
+
+static void vsfsm_thread_entry(void)
 {
-	struct vsfsm_t *sm_pending;
+	struct vsfsm_thread_t *thread = vsfsm_thread_cur;
 	
-	if (sync->sm_pending == sm)
+	thread->op(thread);
+	thread->finished = true;
+	// never return, stack will be released by vsfsm_thread_evt_handler
+	vsfsm_thread_swap(&thread->context, &thread->ret_context);
+}
+
+static struct vsfsm_state_t *
+vsfsm_thread_evt_handler(struct vsfsm_t *sm, vsfsm_evt_t evt)
+{
+	struct vsfsm_thread_t *thread = (struct vsfsm_thread_t *)sm->user_data;
+	struct vsfsm_thread_t *thread_prev;
+	
+	if ((VSFSM_EVT_ENTER == evt) || thread->finished ||
+		((thread->wait_evt != VSFSM_EVT_NONE) && (thread->wait_evt != evt)))
 	{
-		sync->sm_pending = sm->pending_next;
+		return NULL;
 	}
-	else
+	
+	// handler of current thread can post event to another thread directly
+	thread_prev = vsfsm_thread_cur;
+	vsfsm_thread_cur = thread;
+	thread->evt = evt;
+	vsfsm_thread_swap(&thread->ret_context, &thread->context);
+	vsfsm_thread_cur = thread_prev;
+	
+	if (thread->finished)
 	{
-		sm_pending = sync->sm_pending;
-		while (sm_pending->pending_next != NULL)
+		thread->stack_usage = vsfsm_thread_calc_stack_usage(thread);
+		if (thread->pool_stack)
 		{
-			if (sm_pending->pending_next == sm)
-			{
-				sm_pending->pending_next = sm->pending_next;
-				break;
-			}
-			sm_pending = sm_pending->pending_next;
+			vsfsm_thread_free_stack(thread->stack);
+			thread->stack = NULL;
+			thread->pool_stack = false;
 		}
 	}
+	return NULL;
+}
+
+vsf_err_t vsfsm_thread_init(struct vsfsm_t *sm, struct vsfsm_thread_t *thread)
+{
+	uint32_t i;
+	
+	thread->pool_stack = false;
+	if (NULL == thread->stack)
+	{
+		thread->stack = vsfsm_thread_alloc_stack();
+		if (NULL == thread->stack)
+		{
+			return VSFERR_NOT_ENOUGH_RESOURCES;
+		}
+		thread->stack_size = VSFSM_CFG_THREAD_STACK_SIZE;
+		thread->pool_stack = true;
+	}
+	for (i = 0; i < thread->stack_size / sizeof(uint32_t); i++)
+	{
+		thread->stack[i] = VSFSM_THREAD_STACK_MAGIC;
+	}
+	thread->finished = false;
+	thread->stack_usage = 0;
+	// thread starts on VSFSM_EVT_INIT
+	thread->wait_evt = VSFSM_EVT_INIT;
+	vsfsm_thread_context_init(thread);
+	
+	sm->user_data = thread;
+	sm->init_state.evt_handler = vsfsm_thread_evt_handler;
+#if (VSFSM_CFG_SM_EN && VSFSM_CFG_SUBSM_EN) || VSFSM_CFG_HSM_EN
+	vsf_hlist_init(&sm->init_state.subsm);
+#endif
+	thread->sm = sm;
+	return vsfsm_init(sm);
+}
+
+vsfsm_evt_t vsfsm_thread_wait(struct vsfsm_thread_t *thread)
+{
+	thread->wait_evt = VSFSM_EVT_NONE;
+	vsfsm_thread_swap(&thread->context, &thread->ret_context);
+	return thread->evt;
+}
+
+void vsfsm_thread_wfe(struct vsfsm_thread_t *thread, vsfsm_evt_t evt)
+{
+	thread->wait_evt = evt;
+	vsfsm_thread_swap(&thread->context, &thread->ret_context);
+}
+
+uint32_t vsfsm_thread_get_stack_usage(struct vsfsm_thread_t *thread)
+{
+	return (thread->finished || (NULL == thread->stack)) ?
+				thread->stack_usage : vsfsm_thread_calc_stack_usage(thread);
+}
+#endif
+
+#if VSFSM_CFG_SYNC_EN
+// wait queue of vsfsm_sync_t and vsfsm_flag_t is a vsf_dlist_t of
+// 		pending_node of sm, O(1) append and remove
+// pending_list of sm records the wait queue the sm is linked in, because
+// 		vsf_dlist_is_in can not tell which list a linked node belongs to
+#define vsfsm_waitq_init(waitq)			vsf_dlist_init(waitq)
+#define vsfsm_waitq_is_in(waitq, sm)	((sm)->pending_list == (waitq))
+#define vsfsm_waitq_get_sm(node)		\
+	vsf_dlist_get_container(node, struct vsfsm_t, pending_node)
+
+static void vsfsm_waitq_append(struct vsf_dlist_t *waitq, struct vsfsm_t *sm)
+{
+	vsf_dlist_append(waitq, &sm->pending_node);
+	sm->pending_list = waitq;
+}
+
+static void vsfsm_waitq_remove(struct vsf_dlist_t *waitq, struct vsfsm_t *sm)
+{
+	vsf_dlist_remove(waitq, &sm->pending_node);
+	sm->pending_list = NULL;
+}
+
+// vsfsm_sync_t
+#if VSFSM_CFG_PRIORITY_EN
+#define vsfsm_sync_get_waitq(sync, sm)	\
+	&(sync)->pending[min((sm)->priority, VSFSM_SYNC_WAITQ_NUM - 1)]
+#else
+#define vsfsm_sync_get_waitq(sync, sm)	&(sync)->pending[0]
+#endif
+
+#if VSFSM_CFG_SYNC_TIMEOUT_EN
+static void vsfsm_sync_stop_timer(struct vsfsm_t *sm)
+{
+	if (sm->pending_timer != NULL)
+	{
+		vsftimer_unregister(sm->pending_timer);
+		sm->pending_timer = NULL;
+	}
+}
+#else
+#define vsfsm_sync_stop_timer(sm)
+#endif
+
+vsf_err_t vsfsm_sync_init(struct vsfsm_sync_t *sync, uint32_t cur_value,
+				uint32_t max_value, vsfsm_evt_t evt)
+{
+	uint8_t i;
+	
+	sync->cur_value = cur_value;
+	sync->max_value = max_value;
+	sync->evt = evt;
+	for (i = 0; i < VSFSM_SYNC_WAITQ_NUM; i++)
+	{
+		vsfsm_waitq_init(&sync->pending[i]);
+	}
+	return VSFERR_NONE;
+}
+
+vsf_err_t vsfsm_sync_cancel(struct vsfsm_t *sm, struct vsfsm_sync_t *sync)
+{
+	struct vsf_dlist_t *waitq = vsfsm_sync_get_waitq(sync, sm);
+	
+	if (!vsfsm_waitq_is_in(waitq, sm))
+	{
+		return VSFERR_FAIL;
+	}
+	vsfsm_waitq_remove(waitq, sm);
+	vsfsm_sync_stop_timer(sm);
 	return VSFERR_NONE;
 }
 
 vsf_err_t vsfsm_sync_increase(struct vsfsm_t *sm, struct vsfsm_sync_t *sync)
 {
-	if (sync->sm_pending)
+	struct vsfsm_t *sm_pending = NULL;
+	int i;
+	
+	for (i = VSFSM_SYNC_WAITQ_NUM - 1; i >= 0; i--)
 	{
-		if (vsfsm_post_evt(sync->sm_pending, sync->evt))
+		sm_pending = vsfsm_waitq_get_sm(sync->pending[i].head);
+		if (sm_pending != NULL)
+		{
+			// remove before sending the event, because instant event will be
+			// dispatched at once, and the sm may pend on the sync again
+			vsfsm_waitq_remove(&sync->pending[i], sm_pending);
+			break;
+		}
+	}
+	
+	if (sm_pending != NULL)
+	{
+		vsfsm_sync_stop_timer(sm_pending);
+		if (vsfsm_post_evt(sm_pending, sync->evt))
 		{
 			// should increase the evtq buffer size
 			return VSFERR_BUG;
 		}
-		sync->sm_pending = sync->sm_pending->pending_next;
 	}
 	else if (sync->cur_value < sync->max_value)
 	{
@@ -476,7 +1312,106 @@ vsf_err_t vsfsm_sync_decrease(struct vsfsm_t *sm, struct vsfsm_sync_t *sync)
 		sync->cur_value--;
 		return VSFERR_NONE;
 	}
-	vsfsm_sync_append_sm(sm, sync);
+	vsfsm_waitq_append(vsfsm_sync_get_waitq(sync, sm), sm);
 	return VSFERR_NOT_READY;
 }
+
+#if VSFSM_CFG_SYNC_TIMEOUT_EN
+vsf_err_t vsfsm_sync_decrease_timeout(struct vsfsm_t *sm,
+				struct vsfsm_sync_t *sync, struct vsftimer_timer_t *timer)
+{
+	vsf_err_t err = vsfsm_sync_decrease(sm, sync);
+	
+	if (VSFERR_NOT_READY == err)
+	{
+		timer->sm = sm;
+		timer->mode = VSFTIMER_MODE_ONESHOT;
+		sm->pending_timer = timer;
+		vsftimer_register(timer);
+	}
+	return err;
+}
+#endif
+
+// vsfsm_flag_t
+static bool vsfsm_flag_is_satisfied(uint32_t flags, uint32_t mask, bool all)
+{
+	flags &= mask;
+	return all ? (flags == mask) : (flags != 0);
+}
+
+vsf_err_t vsfsm_flag_init(struct vsfsm_flag_t *flag, uint32_t flags,
+				vsfsm_evt_t evt)
+{
+	flag->flags = flags;
+	flag->evt = evt;
+	vsfsm_waitq_init(&flag->pending);
+	return VSFERR_NONE;
+}
+
+vsf_err_t vsfsm_flag_set(struct vsfsm_flag_t *flag, uint32_t flags)
+{
+	struct vsf_dlist_t ready;
+	struct vsfsm_t *sm, *sm_next;
+	vsf_err_t err = VSFERR_NONE;
+	
+	flag->flags |= flags;
+	
+	// move all satisfied sm to ready queue first, because instant event will
+	// be dispatched at once, and the sm may wait on the flag again
+	vsfsm_waitq_init(&ready);
+	sm = vsfsm_waitq_get_sm(flag->pending.head);
+	while (sm != NULL)
+	{
+		sm_next = vsfsm_waitq_get_sm(sm->pending_node.next);
+		if (vsfsm_flag_is_satisfied(flag->flags, sm->pending_flags,
+										sm->pending_all))
+		{
+			vsfsm_waitq_remove(&flag->pending, sm);
+			vsfsm_waitq_append(&ready, sm);
+		}
+		sm = sm_next;
+	}
+	
+	while (!vsf_dlist_is_empty(&ready))
+	{
+		sm = vsfsm_waitq_get_sm(ready.head);
+		vsfsm_waitq_remove(&ready, sm);
+		if (vsfsm_post_evt(sm, flag->evt))
+		{
+			// should increase the evtq buffer size
+			err = VSFERR_BUG;
+		}
+	}
+	return err;
+}
+
+vsf_err_t vsfsm_flag_clear(struct vsfsm_flag_t *flag, uint32_t flags)
+{
+	flag->flags &= ~flags;
+	return VSFERR_NONE;
+}
+
+vsf_err_t vsfsm_flag_wait(struct vsfsm_t *sm, struct vsfsm_flag_t *flag,
+				uint32_t flags, bool all)
+{
+	if (vsfsm_flag_is_satisfied(flag->flags, flags, all))
+	{
+		return VSFERR_NONE;
+	}
+	sm->pending_flags = flags;
+	sm->pending_all = all;
+	vsfsm_waitq_append(&flag->pending, sm);
+	return VSFERR_NOT_READY;
+}
+
+vsf_err_t vsfsm_flag_cancel(struct vsfsm_t *sm, struct vsfsm_flag_t *flag)
+{
+	if (!vsfsm_waitq_is_in(&flag->pending, sm))
+	{
+		return VSFERR_FAIL;
+	}
+	vsfsm_waitq_remove(&flag->pending, sm);
+	return VSFERR_NONE;
+}
 #endif	// VSFSM_CFG_SYNC_EN
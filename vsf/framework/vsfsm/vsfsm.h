@@ -22,6 +22,7 @@
 
 #include "app_type.h"
 #include "vsfsm_cfg.h"
+#include "tool/list/list.h"
 
 enum
 {
@@ -52,7 +53,87 @@ enum
 
 typedef int vsfsm_evt_t;
 
+#if VSFSM_CFG_PRIORITY_EN
+// priority class of the event queue, higher priority queues are always
+// drained first in vsfsm_poll
+enum vsfsm_priority_t
+{
+	VSFSM_PRIORITY_LOW = 0,
+	VSFSM_PRIORITY_NORMAL = 1,
+	VSFSM_PRIORITY_HIGH = 2,
+	VSFSM_PRIORITY_NUM = 3,
+};
+
+// event queue size for every priority class
+#ifndef VSFSM_CFG_EVTQ_LOW_SIZE
+#	define VSFSM_CFG_EVTQ_LOW_SIZE		VSFSM_CFG_EVTQ_SIZE
+#endif
+#ifndef VSFSM_CFG_EVTQ_NORMAL_SIZE
+#	define VSFSM_CFG_EVTQ_NORMAL_SIZE	VSFSM_CFG_EVTQ_SIZE
+#endif
+#ifndef VSFSM_CFG_EVTQ_HIGH_SIZE
+#	define VSFSM_CFG_EVTQ_HIGH_SIZE		VSFSM_CFG_EVTQ_SIZE
+#endif
+#endif
+
+#if VSFSM_CFG_HSM_EN
+// number of cached transition paths, path of a transition is calculated only
+// 		if it's not in the cache
+#ifndef VSFSM_CFG_HSM_PATH_CACHE_SIZE
+#	define VSFSM_CFG_HSM_PATH_CACHE_SIZE	8
+#endif
+// max nesting level of the states, including the topstate
+#ifndef VSFSM_CFG_HSM_MAX_DEPTH
+#	define VSFSM_CFG_HSM_MAX_DEPTH		8
+#endif
+#endif
+
+#if VSFSM_CFG_PROFILE_EN
+// time source of the profiler, tickclk in ms by default,
+// 		define to a cycle counter for better resolution
+#ifndef VSFSM_CFG_PROFILE_GET_TIME
+#	define VSFSM_CFG_PROFILE_GET_TIME()	core_interfaces.tickclk.get_count()
+#endif
+#endif
+
 struct vsfsm_t;
+#if VSFSM_CFG_PROFILE_EN
+// runtime statistics of a sm, updated in vsfsm.c
+struct vsfsm_profile_t
+{
+	const char *name;
+	// events dispatched to the sm
+	uint32_t dispatch_count;
+	// time spent in the event handler, not including nested dispatch
+	uint32_t total_time;
+	uint32_t max_time;
+	// high-water mark of the pending events of the sm
+	uint32_t max_evt_count;
+	// events lost because the event queue or the mailbox is full
+	uint32_t drop_count;
+	
+	// private
+	struct vsfsm_t *next;
+};
+#endif
+#if VSFSM_CFG_MAILBOX_EN
+// optional bounded event queue of a sm
+// events sent to a sm with mailbox are queued in the mailbox instead of the
+// 		global event queue, so a busy sm will not overflow the global queue
+// 		and starve other sm
+struct vsfsm_mailbox_t
+{
+	vsfsm_evt_t *buffer;
+	uint32_t size;
+	
+	// private
+	uint32_t head;
+	uint32_t count;
+	bool ready;
+	struct vsfsm_t *ready_next;
+};
+#endif
+
 struct vsfsm_state_t
 {
 	// return NULL means the event is handled, and no transition
@@ -62,7 +143,7 @@ struct vsfsm_state_t
 	
 #if (VSFSM_CFG_SM_EN && VSFSM_CFG_SUBSM_EN) || VSFSM_CFG_HSM_EN
 	// sub state machine list
-	struct vsfsm_t *subsm;
+	struct vsf_hlist_t subsm;
 #endif
 	
 #if VSFSM_CFG_HSM_EN
@@ -71,6 +152,10 @@ struct vsfsm_state_t
 #endif
 };
 
+#if VSFSM_CFG_SYNC_EN && VSFSM_CFG_SYNC_TIMEOUT_EN
+struct vsftimer_timer_t;
+#endif
+
 struct vsfsm_t
 {
 	// initial state
@@ -81,21 +166,43 @@ struct vsfsm_t
 	// for protothread, user_data should point to vsfsm_pt_t structure
 	// 		which will be initialized in vsfsm_pt_init
 	void *user_data;
+#if VSFSM_CFG_PRIORITY_EN
+	// default priority of the events posted to the sm
+	uint8_t priority;
+#endif
+#if VSFSM_CFG_MAILBOX_EN
+	// mailbox is optional and MUST be initialized before vsfsm_init
+	struct vsfsm_mailbox_t *mailbox;
+#endif
 	
 	// private
 #if VSFSM_CFG_SM_EN || VSFSM_CFG_HSM_EN
 	struct vsfsm_state_t *cur_state;
 # endif
 #if VSFSM_CFG_SYNC_EN
-	// pending_next is used for vsfsm_sync_t
-	struct vsfsm_t *pending_next;
+	// pending_node is used to link the sm in the wait queue
+	// 		of vsfsm_sync_t or vsfsm_flag_t
+	struct vsf_dlist_node_t pending_node;
+	// wait queue the sm is pending in, NULL if not pending
+	struct vsf_dlist_t *pending_list;
+	// flags waited by the sm in vsfsm_flag_t
+	uint32_t pending_flags;
+	bool pending_all;
+#if VSFSM_CFG_SYNC_TIMEOUT_EN
+	// timeout timer of the pending vsfsm_sync_decrease_timeout,
+	// 		still set after the timer expires, until vsfsm_sync_cancel
+	struct vsftimer_timer_t *pending_timer;
+#endif
 #endif
 #if VSFSM_CFG_ACTIVE_EN
 	volatile bool active;
 #endif
 #if (VSFSM_CFG_SM_EN && VSFSM_CFG_SUBSM_EN) || VSFSM_CFG_HSM_EN
-	// next is used to link vsfsm_t in the same level
-	struct vsfsm_t *next;
+	// subsm_node is used to link vsfsm_t in the same level
+	struct vsf_hlist_node_t subsm_node;
+#endif
+#if VSFSM_CFG_PROFILE_EN
+	struct vsfsm_profile_t profile;
 #endif
 	uint32_t evt_count;
 };
@@ -146,12 +253,70 @@ vsf_err_t vsfsm_pt_init(struct vsfsm_t *sm, struct vsfsm_pt_t *pt);
 #define vsfsm_pt_end(pt)				}
 #endif
 
+#if VSFSM_CFG_THREAD_EN
+// stackful thread, different from vsfsm_pt_t, locals of the thread are kept
+// 		while waiting for events
+// context switch is implemented for Cortex-M and hosts with ucontext
+#if defined(__ICCARM__) || defined(__arm__)
+// saved stack pointer, registers are saved on the stack
+typedef uint32_t vsfsm_thread_context_t;
+#else
+#include <ucontext.h>
+typedef ucontext_t vsfsm_thread_context_t;
+#endif
+
+// stacks in the stack pool are used by threads without user stack
+#ifndef VSFSM_CFG_THREAD_STACK_NUM
+#	define VSFSM_CFG_THREAD_STACK_NUM	2
+#endif
+#ifndef VSFSM_CFG_THREAD_STACK_SIZE
+#	define VSFSM_CFG_THREAD_STACK_SIZE	1024
+#endif
+
+struct vsfsm_thread_t;
+typedef void (*vsfsm_thread_op_t)(struct vsfsm_thread_t *thread);
+struct vsfsm_thread_t
+{
+	vsfsm_thread_op_t op;
+	void *user_data;
+	// stack can be NULL to allocate from the stack pool
+	// note that the size of the stack MUST be large enough for the interrupts
+	uint32_t *stack;
+	uint32_t stack_size;
+	
+	// protected
+	struct vsfsm_t *sm;
+	
+	// private
+	vsfsm_evt_t evt;
+	vsfsm_evt_t wait_evt;
+	bool pool_stack;
+	bool finished;
+	uint32_t stack_usage;
+	vsfsm_thread_context_t context;
+	vsfsm_thread_context_t ret_context;
+};
+
+// thread will start running in vsfsm_thread_init, and the stack will be
+// 		released if allocated from the stack pool when op returns
+vsf_err_t vsfsm_thread_init(struct vsfsm_t *sm, struct vsfsm_thread_t *thread);
+// called in thread only, wait for any event and return it
+vsfsm_evt_t vsfsm_thread_wait(struct vsfsm_thread_t *thread);
+// called in thread only, wait for evt, other events are ignored
+void vsfsm_thread_wfe(struct vsfsm_thread_t *thread, vsfsm_evt_t evt);
+// get the high-water mark of the stack in bytes
+uint32_t vsfsm_thread_get_stack_usage(struct vsfsm_thread_t *thread);
+#endif
+
 // vsfsm_get_event_pending should be called with interrupt disabled
 uint32_t vsfsm_get_event_pending(void);
 
 #if (VSFSM_CFG_SM_EN && VSFSM_CFG_SUBSM_EN) || VSFSM_CFG_HSM_EN
 extern struct vsfsm_state_t vsfsm_top;
 // sub-statemachine add/remove
+// a sm can be sub-statemachine of only one state, and is not added again if
+// 		it's already added, subsm_node of the sm MUST be cleared before added
+// 		for the first time
 vsf_err_t vsfsm_add_subsm(struct vsfsm_state_t *state, struct vsfsm_t *sm);
 vsf_err_t vsfsm_remove_subsm(struct vsfsm_state_t *state, struct vsfsm_t *sm);
 #endif
@@ -166,8 +331,57 @@ vsf_err_t vsfsm_set_active(struct vsfsm_t *sm, bool active);
 #endif
 vsf_err_t vsfsm_post_evt(struct vsfsm_t *sm, vsfsm_evt_t evt);
 vsf_err_t vsfsm_post_evt_pending(struct vsfsm_t *sm, vsfsm_evt_t evt);
+// vsfsm_post_evt_coalesce is used for notification events,
+// 		same as vsfsm_post_evt_pending, but the event is ignored if it's already
+// 		pending in the mailbox of the sm
+#if VSFSM_CFG_MAILBOX_EN
+vsf_err_t vsfsm_post_evt_coalesce(struct vsfsm_t *sm, vsfsm_evt_t evt);
+#else
+#define vsfsm_post_evt_coalesce(sm, evt)	vsfsm_post_evt_pending((sm), (evt))
+#endif
+
+#if VSFSM_CFG_PRIORITY_EN
+// same as vsfsm_post_evt/vsfsm_post_evt_pending,
+// 		but override the default priority of the sm
+vsf_err_t vsfsm_post_evt_prio(struct vsfsm_t *sm, vsfsm_evt_t evt,
+								uint8_t priority);
+vsf_err_t vsfsm_post_evt_pending_prio(struct vsfsm_t *sm, vsfsm_evt_t evt,
+								uint8_t priority);
+#endif
+
+// depth counters of the event queue, used to size the queues
+// priority MUST be 0 if VSFSM_CFG_PRIORITY_EN is not enabled
+struct vsfsm_evtq_status_t
+{
+	uint32_t size;
+	uint32_t count;
+	uint32_t max_count;
+	uint32_t drop_count;
+};
+vsf_err_t vsfsm_get_evtq_status(uint8_t priority,
+								struct vsfsm_evtq_status_t *status);
+
+#if VSFSM_CFG_PROFILE_EN
+// only registered sm can be listed by vsfsm_profile_get
+vsf_err_t vsfsm_profile_register(struct vsfsm_t *sm, const char *name);
+vsf_err_t vsfsm_profile_unregister(struct vsfsm_t *sm);
+// get a copy of the profile of the index-th registered sm
+// return VSFERR_FAIL if index is out of range
+vsf_err_t vsfsm_profile_get(uint32_t index, struct vsfsm_profile_t *profile);
+// reset statistics of all registered sm and the event queues
+void vsfsm_profile_reset(void);
+#endif
 
 #if VSFSM_CFG_SYNC_EN
+#if VSFSM_CFG_PRIORITY_EN
+// one wait queue for every priority class, pending sm with higher priority
+// 		will be woken up first, FIFO in the same priority class
+// priority of the sm MUST NOT be changed while pending
+#define VSFSM_SYNC_WAITQ_NUM		VSFSM_PRIORITY_NUM
+#else
+#define VSFSM_SYNC_WAITQ_NUM		1
+#endif
+
 // vsfsm_sync_t is generic sync object
 struct vsfsm_sync_t
 {
@@ -176,13 +390,26 @@ struct vsfsm_sync_t
 	
 	// private
 	uint32_t max_value;
-	struct vsfsm_t *sm_pending;
+	// wait queues of pending sm
+	struct vsf_dlist_t pending[VSFSM_SYNC_WAITQ_NUM];
 };
 vsf_err_t vsfsm_sync_init(struct vsfsm_sync_t *sem, uint32_t cur_value,
 				uint32_t max_value, vsfsm_evt_t evt);
+// return VSFERR_FAIL if sm is not pending on the sync, which means that
+// 		the sync is already acquired and sync->evt is sent to the sm
 vsf_err_t vsfsm_sync_cancel(struct vsfsm_t *sm, struct vsfsm_sync_t *sync);
 vsf_err_t vsfsm_sync_increase(struct vsfsm_t *sm, struct vsfsm_sync_t *sync);
 vsf_err_t vsfsm_sync_decrease(struct vsfsm_t *sm, struct vsfsm_sync_t *sync);
+#if VSFSM_CFG_SYNC_TIMEOUT_EN
+// same as vsfsm_sync_decrease, but timer(interval and evt initialized by
+// 		caller) will be registered as one-shot timer while pending, timer->evt will be sent
+// 		to the sm on timeout, and the sm SHOULD call vsfsm_sync_cancel then
+// timer is unregistered when the sync is acquired or cancelled
+// timer is still referenced by the sm after it expires, and MUST NOT be
+// 		reused until vsfsm_sync_cancel is called
+vsf_err_t vsfsm_sync_decrease_timeout(struct vsfsm_t *sm,
+				struct vsfsm_sync_t *sync, struct vsftimer_timer_t *timer);
+#endif
 
 // SEMAPHORE
 #define vsfsm_sem_t					vsfsm_sync_t
@@ -197,6 +424,29 @@ vsf_err_t vsfsm_sync_decrease(struct vsfsm_t *sm, struct vsfsm_sync_t *sync);
 #define vsfsm_crit_enter(sm, crit)	vsfsm_sync_decrease((sm), (crit))
 #define vsfsm_crit_leave(sm, crit)	vsfsm_sync_increase((sm), (crit))
 
+// EVENT FLAG
+// vsfsm_flag_t is a group of event flags, sm can wait for any or all of
+// 		the flags in the mask, flags are not cleared when sm is woken up
+struct vsfsm_flag_t
+{
+	uint32_t flags;
+	vsfsm_evt_t evt;
+	
+	// private
+	struct vsf_dlist_t pending;
+};
+vsf_err_t vsfsm_flag_init(struct vsfsm_flag_t *flag, uint32_t flags,
+				vsfsm_evt_t evt);
+// wake up all the pending sm whose flags are satisfied by sending flag->evt
+vsf_err_t vsfsm_flag_set(struct vsfsm_flag_t *flag, uint32_t flags);
+vsf_err_t vsfsm_flag_clear(struct vsfsm_flag_t *flag, uint32_t flags);
+// return VSFERR_NONE if flags are already satisfied, else VSFERR_NOT_READY
+// 		and flag->evt will be sent to the sm when satisfied
+vsf_err_t vsfsm_flag_wait(struct vsfsm_t *sm, struct vsfsm_flag_t *flag,
+				uint32_t flags, bool all);
+// return VSFERR_FAIL if sm is not pending on the flag
+vsf_err_t vsfsm_flag_cancel(struct vsfsm_t *sm, struct vsfsm_flag_t *flag);
+
 #endif	// VSFSM_CFG_SYNC_EN
 
 #endif	// #ifndef __VSFSM_H_INCLUDED__
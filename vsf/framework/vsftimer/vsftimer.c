@@ -17,34 +17,226 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+#include "compiler.h"
 #include "vsftimer.h"
 #include "interfaces.h"
 #include "framework/vsfsm/vsfsm.h"
 
 #define VSFSM_EVT_TIMER					8
 
+#define VSFTIMER_WHEEL_SLOTS			(1UL << VSFTIMER_CFG_WHEEL_BITS)
+#define VSFTIMER_WHEEL_MASK				(VSFTIMER_WHEEL_SLOTS - 1)
+// range in ticks covered by the lowest (level) levels
+#define VSFTIMER_WHEEL_RANGE(level)		\
+	(1UL << (VSFTIMER_CFG_WHEEL_BITS * (level)))
+#define VSFTIMER_WHEEL_INDEX(tick, level)	\
+	(((tick) >> (VSFTIMER_CFG_WHEEL_BITS * (level))) & VSFTIMER_WHEEL_MASK)
+
+#if (VSFTIMER_CFG_WHEEL_BITS * VSFTIMER_CFG_WHEEL_LEVELS) > 31
+#	error "range of the timing wheel MUST be less than 31 bits"
+#endif
+
+#if VSFTIMER_CFG_HIRES_EN
+#if !IFS_TIMER_EN
+#	error "high resolution timer depends on IFS_TIMER_EN"
+#endif
+// level of the high resolution timers, which are not in the timing wheel
+#define VSFTIMER_LEVEL_HIRES			0xFF
+#define VSFTIMER_HIRES_MASK				\
+	(0xFFFFFFFF >> (32 - VSFTIMER_CFG_HIRES_BITS))
+#define VSFTIMER_HIRES_HALF				(1UL << (VSFTIMER_CFG_HIRES_BITS - 1))
+
+static bool vsftimer_hires_before(struct vsf_heap_node_t *a,
+									struct vsf_heap_node_t *b);
+// high resolution timers sorted by deadline, accessed in interrupt
+static struct vsf_heap_t vsftimer_hires_heap = {vsftimer_hires_before};
+#endif
+
 static struct vsfsm_state_t *
 vsftimer_init_handler(struct vsfsm_t *sm, vsfsm_evt_t evt);
 
 struct vsftimer_t
 {
-	struct vsftimer_timer_t *timerlist;
 	struct vsfsm_t sm;
+#if VSFSM_CFG_MAILBOX_EN
+	struct vsfsm_mailbox_t mailbox;
+	vsfsm_evt_t mailbox_buffer[1];
+#endif
+	
+	// all timers before wheel_tick are processed
+	uint32_t wheel_tick;
+	// number of timers in every level, used to skip empty levels
+	uint32_t count[VSFTIMER_CFG_WHEEL_LEVELS];
+	struct vsf_hlist_t wheel[VSFTIMER_CFG_WHEEL_LEVELS][VSFTIMER_WHEEL_SLOTS];
+	struct vsftimer_stat_t stat;
 } static vsftimer =
 {
-	NULL,
 	{
 		{
 			vsftimer_init_handler,
 		},								// struct vsfsm_state_t init_state;
-	},
+	},									// struct vsfsm_t sm;
 };
 
+static void vsftimer_wheel_insert(struct vsftimer_timer_t *timer)
+{
+	uint32_t deadline = timer->deadline;
+	uint32_t delta = deadline - vsftimer.wheel_tick;
+	struct vsf_hlist_t *slot;
+	uint8_t level;
+	
+	if ((int32_t)delta < 0)
+	{
+		// already expired, process in the next tick
+		deadline = vsftimer.wheel_tick;
+		delta = 0;
+	}
+	else if (delta >= VSFTIMER_WHEEL_RANGE(VSFTIMER_CFG_WHEEL_LEVELS))
+	{
+		// out of range, will be re-scheduled when cascaded
+		delta = VSFTIMER_WHEEL_RANGE(VSFTIMER_CFG_WHEEL_LEVELS) - 1;
+		deadline = vsftimer.wheel_tick + delta;
+	}
+	
+	for (level = 0; delta >= VSFTIMER_WHEEL_RANGE(level + 1); level++);
+	slot = &vsftimer.wheel[level][VSFTIMER_WHEEL_INDEX(deadline, level)];
+	
+	timer->level = level;
+	vsf_hlist_add_head(slot, &timer->node);
+	vsftimer.count[level]++;
+}
+
+static void vsftimer_wheel_remove(struct vsftimer_timer_t *timer)
+{
+	vsf_hlist_remove(&timer->node);
+	vsftimer.count[timer->level]--;
+}
+
+static void vsftimer_reschedule(struct vsftimer_timer_t *timer,
+								uint32_t cur_tickcnt)
+{
+	// timer with 0 interval is triggered at most once every tick
+	uint32_t interval = max(timer->interval, 1);
+	
+	switch (timer->mode)
+	{
+	case VSFTIMER_MODE_ONESHOT:
+		return;
+	case VSFTIMER_MODE_PHASE_LOCKED:
+		timer->deadline += interval;
+		if ((int32_t)(cur_tickcnt - timer->deadline) >= 0)
+		{
+			// skip the missed periods, and keep the phase
+			timer->deadline += ((cur_tickcnt - timer->deadline) / interval + 1)
+								* interval;
+		}
+		break;
+	default:
+		timer->deadline = cur_tickcnt + interval;
+		break;
+	}
+	vsftimer_wheel_insert(timer);
+}
+
+#define vsftimer_get_timer(p)			\
+	vsf_hlist_get_container(p, struct vsftimer_timer_t, node)
+
+// called when wheel_tick is at the boundary of the first level,
+// 		move timers in the higher levels to the lower levels
+static void vsftimer_wheel_cascade(void)
+{
+	struct vsftimer_timer_t *timer;
+	struct vsf_hlist_t list;
+	uint32_t index;
+	uint8_t level;
+	
+	for (level = 1; level < VSFTIMER_CFG_WHEEL_LEVELS; level++)
+	{
+		index = VSFTIMER_WHEEL_INDEX(vsftimer.wheel_tick, level);
+		// detach timers in slot to list, so that the timers can be
+		// 		re-inserted while the list is being processed
+		vsf_hlist_move(&vsftimer.wheel[level][index], &list);
+		while (!vsf_hlist_is_empty(&list))
+		{
+			timer = vsftimer_get_timer(list.head);
+			vsftimer_wheel_remove(timer);
+			vsftimer_wheel_insert(timer);
+		}
+		if (index != 0)
+		{
+			break;
+		}
+	}
+}
+
+static void vsftimer_wheel_run(uint32_t cur_tickcnt)
+{
+	struct vsftimer_timer_t *timer;
+	struct vsf_hlist_t list;
+	uint32_t mask, next_tick, expired = 0;
+	uint8_t level;
+	
+	while ((int32_t)(cur_tickcnt - vsftimer.wheel_tick) >= 0)
+	{
+		// skip ticks if there is no timer in the lower levels, wheel_tick
+		// 		stops at the boundary on which the lowest level is cascaded
+		for (level = 0; (level < VSFTIMER_CFG_WHEEL_LEVELS) &&
+				!vsftimer.count[level]; level++);
+		if (level >= VSFTIMER_CFG_WHEEL_LEVELS)
+		{
+			vsftimer.wheel_tick = cur_tickcnt + 1;
+			break;
+		}
+		mask = VSFTIMER_WHEEL_RANGE(level) - 1;
+		if ((level > 0) && (vsftimer.wheel_tick & mask))
+		{
+			next_tick = (vsftimer.wheel_tick | mask) + 1;
+			if ((int32_t)(next_tick - cur_tickcnt) > 0)
+			{
+				vsftimer.wheel_tick = cur_tickcnt + 1;
+				break;
+			}
+			vsftimer.wheel_tick = next_tick;
+			continue;
+		}
+		
+		if (!VSFTIMER_WHEEL_INDEX(vsftimer.wheel_tick, 0))
+		{
+			vsftimer_wheel_cascade();
+		}
+		vsf_hlist_move(&vsftimer.wheel[0][
+				VSFTIMER_WHEEL_INDEX(vsftimer.wheel_tick, 0)], &list);
+		vsftimer.wheel_tick++;
+		
+		while (!vsf_hlist_is_empty(&list))
+		{
+			// triggered
+			timer = vsftimer_get_timer(list.head);
+			vsftimer_wheel_remove(timer);
+			// re-schedule before sending the event, so that the event
+			// handler can unregister or re-register the timer
+			vsftimer_reschedule(timer, cur_tickcnt);
+			if ((timer->sm != NULL) && (timer->evt != VSFSM_EVT_INVALID))
+			{
+				vsfsm_post_evt(timer->sm, timer->evt);
+			}
+			expired++;
+		}
+	}
+	
+	if (expired)
+	{
+		vsftimer.stat.wakeup_count++;
+		vsftimer.stat.wakeup_saved += expired - 1;
+	}
+}
+
 // vsftimer_callback_int is called in interrupt,
 // simply send event to vsftimer SM
+// VSFSM_EVT_TIMER is coalesced, because every event will process all timers
 void vsftimer_callback_int(void)
 {
-	vsfsm_post_evt_pending(&vsftimer.sm, VSFSM_EVT_TIMER);
+	vsfsm_post_evt_coalesce(&vsftimer.sm, VSFSM_EVT_TIMER);
 }
 
 static struct vsfsm_state_t *
@@ -53,30 +245,8 @@ vsftimer_init_handler(struct vsfsm_t *sm, vsfsm_evt_t evt)
 	switch (evt)
 	{
 	case VSFSM_EVT_TIMER:
-	{
-		uint32_t cur_tickcnt = core_interfaces.tickclk.get_count();
-		struct vsftimer_timer_t timer, *ptimer = vsftimer.timerlist;
-		
-		while (ptimer != NULL)
-		{
-			// save timer on stack in case event handler of the state machine
-			// unregister and free the timer, beause timer on stack maintain
-			// the list pointing to the next timer
-			timer = *ptimer;
-			if ((cur_tickcnt - timer.start_tickcnt) >= timer.interval)
-			{
-				// triggered
-				ptimer->start_tickcnt = cur_tickcnt;
-				if ((timer.sm != NULL) && (timer.evt != VSFSM_EVT_INVALID))
-				{
-					vsfsm_post_evt(timer.sm, timer.evt);
-				}
-			}
-			ptimer = sllist_get_container(timer.list.next,
-											struct vsftimer_timer_t, list);
-		}
+		vsftimer_wheel_run(core_interfaces.tickclk.get_count());
 		return NULL;
-	}
 	default:
 		return NULL;
 	}
@@ -84,36 +254,222 @@ vsftimer_init_handler(struct vsfsm_t *sm, vsfsm_evt_t evt)
 
 vsf_err_t vsftimer_init(void)
 {
-	vsftimer.timerlist = NULL;
+	memset(vsftimer.count, 0, sizeof(vsftimer.count));
+	memset(vsftimer.wheel, 0, sizeof(vsftimer.wheel));
+	memset(&vsftimer.stat, 0, sizeof(vsftimer.stat));
+	vsftimer.wheel_tick = core_interfaces.tickclk.get_count();
+#if VSFSM_CFG_PRIORITY_EN
+	vsftimer.sm.priority = VSFSM_PRIORITY_HIGH;
+#endif
+#if VSFSM_CFG_MAILBOX_EN
+	vsftimer.mailbox.buffer = vsftimer.mailbox_buffer;
+	vsftimer.mailbox.size = dimof(vsftimer.mailbox_buffer);
+	vsftimer.sm.mailbox = &vsftimer.mailbox;
+#endif
+#if VSFSM_CFG_PROFILE_EN
+	vsfsm_profile_register(&vsftimer.sm, "timer");
+#endif
 	return vsfsm_init(&vsftimer.sm);
 }
 
+vsf_err_t vsftimer_register_deadline(struct vsftimer_timer_t *timer,
+										uint32_t deadline)
+{
+	vsftimer_unregister(timer);
+	timer->deadline = deadline;
+	vsftimer_wheel_insert(timer);
+	return VSFERR_NONE;
+}
+
 vsf_err_t vsftimer_register(struct vsftimer_timer_t *timer)
 {
-	timer->start_tickcnt = core_interfaces.tickclk.get_count();
-	if (NULL == vsftimer.timerlist)
+	return vsftimer_register_deadline(timer,
+					core_interfaces.tickclk.get_count() + timer->interval);
+}
+
+vsf_err_t vsftimer_unregister(struct vsftimer_timer_t *timer)
+{
+#if VSFTIMER_CFG_HIRES_EN
+	if (VSFTIMER_LEVEL_HIRES == timer->level)
 	{
-		vsftimer.timerlist = timer;
+		vsf_enter_critical();
+		if (vsf_heap_is_in(&vsftimer_hires_heap, &timer->heap_node))
+		{
+			vsf_heap_remove(&vsftimer_hires_heap, &timer->heap_node);
+		}
+		vsf_leave_critical();
 		return VSFERR_NONE;
 	}
-	if (!sllist_is_in(&vsftimer.timerlist->list, &timer->list))
+#endif
+	if (vsf_hlist_is_linked(&timer->node))
 	{
-		if (vsftimer.timerlist != NULL)
+		vsftimer_wheel_remove(timer);
+	}
+	return VSFERR_NONE;
+}
+
+// timers MUST expire before deadline + slack, the slots are scanned in order
+// 		until the start of the slot is later than the result
+// timers out of the range of the wheel are counted at the end of the slot,
+// 		because they are re-scheduled there
+uint32_t vsftimer_get_idle_ticks(void)
+{
+	uint32_t cur_tickcnt = core_interfaces.tickclk.get_count();
+	uint32_t index, i, slot_start, slot_end, latest, ticks;
+	uint32_t idle_ticks = 0xFFFFFFFF;
+	struct vsf_hlist_node_t *node;
+	struct vsftimer_timer_t *timer;
+	uint8_t level;
+	
+	for (level = 0; level < VSFTIMER_CFG_WHEEL_LEVELS; level++)
+	{
+		if (!vsftimer.count[level])
+		{
+			continue;
+		}
+		
+		// current slot of higher levels is already cascaded, unless
+		// 		wheel_tick is on the boundary which is not processed yet
+		index = vsftimer.wheel_tick >> (VSFTIMER_CFG_WHEEL_BITS * level);
+		if (vsftimer.wheel_tick & (VSFTIMER_WHEEL_RANGE(level) - 1))
+		{
+			index++;
+		}
+		for (i = 0; i < VSFTIMER_WHEEL_SLOTS; i++, index++)
 		{
-			sllist_insert(timer->list, vsftimer.timerlist->list);
+			slot_start = index << (VSFTIMER_CFG_WHEEL_BITS * level);
+			ticks = slot_start - cur_tickcnt;
+			if (((int32_t)ticks > 0) && (ticks >= idle_ticks))
+			{
+				break;
+			}
+			slot_end = slot_start + VSFTIMER_WHEEL_RANGE(level) - 1;
+			
+			node = vsftimer.wheel[level][index & VSFTIMER_WHEEL_MASK].head;
+			for (; node != NULL; node = node->next)
+			{
+				timer = vsftimer_get_timer(node);
+				latest = ((int32_t)(slot_end - timer->deadline) < 0) ?
+							slot_end : timer->deadline + timer->slack;
+				ticks = latest - cur_tickcnt;
+				if ((int32_t)ticks <= 0)
+				{
+					return 0;
+				}
+				idle_ticks = min(idle_ticks, ticks);
+			}
 		}
-		vsftimer.timerlist = timer;
 	}
-	return VSFERR_NONE;
+	return idle_ticks;
 }
 
-vsf_err_t vsftimer_unregister(struct vsftimer_timer_t *timer)
+void vsftimer_get_stat(struct vsftimer_stat_t *stat)
+{
+	*stat = vsftimer.stat;
+}
+
+void vsftimer_reset_stat(void)
+{
+	memset(&vsftimer.stat, 0, sizeof(vsftimer.stat));
+}
+
+#if VSFTIMER_CFG_HIRES_EN
+#define vsftimer_hires_get_timer(p)		\
+	vsf_heap_get_container(p, struct vsftimer_timer_t, heap_node)
+
+static uint32_t vsftimer_hires_get_count(void)
+{
+	uint32_t count = 0;
+	
+	core_interfaces.timer.get_count(VSFTIMER_CFG_HIRES_TIMER, &count);
+	return count & VSFTIMER_HIRES_MASK;
+}
+
+// counts before the deadline, 0 if expired
+static uint32_t vsftimer_hires_get_remain(uint32_t deadline, uint32_t count)
+{
+	uint32_t remain = (deadline - count) & VSFTIMER_HIRES_MASK;
+	return (remain >= VSFTIMER_HIRES_HALF) ? 0 : remain;
+}
+
+// deadlines of registered timers are within half range of the counter
+static bool vsftimer_hires_before(struct vsf_heap_node_t *a,
+									struct vsf_heap_node_t *b)
 {
-	if (vsftimer.timerlist == timer)
+	uint32_t delta = vsftimer_hires_get_timer(a)->deadline -
+						vsftimer_hires_get_timer(b)->deadline;
+	return (delta & VSFTIMER_HIRES_MASK) >= VSFTIMER_HIRES_HALF;
+}
+
+// called in compare interrupt, or with interrupt disabled
+static void vsftimer_hires_callback_int(void)
+{
+	struct vsf_heap_node_t *node;
+	struct vsftimer_timer_t *timer;
+	
+	while ((node = vsf_heap_get_first(&vsftimer_hires_heap)) != NULL)
 	{
-		vsftimer.timerlist = sllist_get_container(timer->list.next,
-								struct vsftimer_timer_t, list);
-		return VSFERR_NONE;
+		timer = vsftimer_hires_get_timer(node);
+		if (vsftimer_hires_get_remain(timer->deadline,
+										vsftimer_hires_get_count()))
+		{
+			core_interfaces.timer.set_channel(VSFTIMER_CFG_HIRES_TIMER,
+									VSFTIMER_CFG_HIRES_CHANNEL, timer->deadline);
+			// if the counter passed the deadline while setting the channel,
+			// 		process it now, or it will be delayed a whole round
+			if (vsftimer_hires_get_remain(timer->deadline,
+											vsftimer_hires_get_count()))
+			{
+				break;
+			}
+			continue;
+		}
+		
+		vsf_heap_remove(&vsftimer_hires_heap, node);
+		if ((timer->sm != NULL) && (timer->evt != VSFSM_EVT_INVALID))
+		{
+			vsfsm_post_evt_pending(timer->sm, timer->evt);
+		}
+	}
+}
+
+vsf_err_t vsftimer_hires_init(void)
+{
+	vsf_heap_init(&vsftimer_hires_heap);
+	if (core_interfaces.timer.init(VSFTIMER_CFG_HIRES_TIMER) ||
+		core_interfaces.timer.config(VSFTIMER_CFG_HIRES_TIMER,
+									VSFTIMER_CFG_HIRES_KHZ, 0, NULL) ||
+		core_interfaces.timer.config_channel(VSFTIMER_CFG_HIRES_TIMER,
+				VSFTIMER_CFG_HIRES_CHANNEL, 0, vsftimer_hires_callback_int))
+	{
+		return VSFERR_FAIL;
 	}
-	return sllist_remove(&vsftimer.timerlist->list.next, &timer->list);
+	return core_interfaces.timer.start(VSFTIMER_CFG_HIRES_TIMER);
+}
+
+vsf_err_t vsftimer_hires_register(struct vsftimer_timer_t *timer)
+{
+	uint32_t count;
+	
+	if (!timer->interval || (timer->interval >= VSFTIMER_HIRES_HALF))
+	{
+		return VSFERR_INVALID_PARAMETER;
+	}
+	
+	vsftimer_unregister(timer);
+	vsf_enter_critical();
+	count = vsftimer_hires_get_count();
+	timer->deadline = (count + timer->interval) & VSFTIMER_HIRES_MASK;
+	timer->level = VSFTIMER_LEVEL_HIRES;
+	
+	vsf_heap_insert(&vsftimer_hires_heap, &timer->heap_node);
+	
+	if (vsf_heap_get_first(&vsftimer_hires_heap) == &timer->heap_node)
+	{
+		// earliest timer changed, re-program the compare channel
+		vsftimer_hires_callback_int();
+	}
+	vsf_leave_critical();
+	return VSFERR_NONE;
 }
+#endif
@@ -20,24 +20,107 @@
 #ifndef __VSFTIMER_H_INCLUDED__
 #define __VSFTIMER_H_INCLUDED__
 
-#include "tool/list/list.h"
 #include "framework/vsfsm/vsfsm.h"
+#include "tool/list/list.h"
+
+// timers are kept in a hierarchical timing wheel of VSFTIMER_CFG_WHEEL_LEVELS
+// levels, every level has (1 << VSFTIMER_CFG_WHEEL_BITS) slots
+// timers expiring later than the range of the wheel will be re-scheduled
+// when the last level is cascaded
+#ifndef VSFTIMER_CFG_WHEEL_BITS
+#	define VSFTIMER_CFG_WHEEL_BITS		4
+#endif
+#ifndef VSFTIMER_CFG_WHEEL_LEVELS
+#	define VSFTIMER_CFG_WHEEL_LEVELS	6
+#endif
 
+#if VSFTIMER_CFG_HIRES_EN
+// high resolution timers are driven by a compare channel of interface_timer_t
+// 		whose counter is free-running at VSFTIMER_CFG_HIRES_KHZ
+#ifndef VSFTIMER_CFG_HIRES_TIMER
+#	define VSFTIMER_CFG_HIRES_TIMER		1
+#endif
+#ifndef VSFTIMER_CFG_HIRES_CHANNEL
+#	define VSFTIMER_CFG_HIRES_CHANNEL	0
+#endif
+#ifndef VSFTIMER_CFG_HIRES_KHZ
+#	define VSFTIMER_CFG_HIRES_KHZ		1000
+#endif
+// bit width of the counter
+#ifndef VSFTIMER_CFG_HIRES_BITS
+#	define VSFTIMER_CFG_HIRES_BITS		16
+#endif
+#endif
+
+enum vsftimer_mode_t
+{
+	// re-scheduled from the time the timer is processed, so the latency
+	// 		of processing is accumulated
+	VSFTIMER_MODE_PERIODIC = 0,
+	// re-scheduled from the previous deadline without drift,
+	// 		periods missed are skipped
+	VSFTIMER_MODE_PHASE_LOCKED = 1,
+	// unregistered before the event is sent
+	VSFTIMER_MODE_ONESHOT = 2,
+};
+
+// private members MUST be cleared before the timer is registered
+// 		for the first time
 struct vsftimer_timer_t
 {
 	uint32_t interval;
 	struct vsfsm_t *sm;
 	vsfsm_evt_t evt;
+	// enum vsftimer_mode_t
+	uint8_t mode;
+	// timer can expire in [deadline, deadline + slack], in tickless idle,
+	// 		timers whose windows overlap are expired in one wakeup
+	uint32_t slack;
 	
 	// private
-	struct sllist list;
-	uint32_t start_tickcnt;
+	// node links the timer in the slot of the timing wheel,
+	// 		and is not linked if the timer is not registered
+	struct vsf_hlist_node_t node;
+#if VSFTIMER_CFG_HIRES_EN
+	// heap_node links the high resolution timer in the heap of deadlines
+	struct vsf_heap_node_t heap_node;
+#endif
+	uint32_t deadline;
+	uint8_t level;
+};
+
+struct vsftimer_stat_t
+{
+	// processings of the timers in which at least one timer expired
+	uint32_t wakeup_count;
+	// timers expired together with other timers in one processing,
+	// 		which would have needed their own wakeups
+	uint32_t wakeup_saved;
 };
 
 vsf_err_t vsftimer_init(void);
 // call vsftimer_callback_int in hw timer interrupt
 void vsftimer_callback_int(void);
+// register a registered timer will restart it
 vsf_err_t vsftimer_register(struct vsftimer_timer_t *timer);
+// same as vsftimer_register, but first expires at the absolute tick count
+vsf_err_t vsftimer_register_deadline(struct vsftimer_timer_t *timer,
+										uint32_t deadline);
+// unregister tick timer or high resolution timer
 vsf_err_t vsftimer_unregister(struct vsftimer_timer_t *timer);
+// get ticks before the earliest registered timer MUST expire(including
+// 		slack), 0 if already expired and 0xFFFFFFFF if no timer is registered
+// used to delay tickclk interrupt in tickless idle
+uint32_t vsftimer_get_idle_ticks(void);
+void vsftimer_get_stat(struct vsftimer_stat_t *stat);
+void vsftimer_reset_stat(void);
+
+#if VSFTIMER_CFG_HIRES_EN
+vsf_err_t vsftimer_hires_init(void);
+// high resolution timer is always one-shot, interval is in counts of
+// 		the hardware timer and MUST be less than half range of the counter
+// timer->evt is sent in interrupt
+vsf_err_t vsftimer_hires_register(struct vsftimer_timer_t *timer);
+#endif
 
 #endif	// #ifndef __VSFTIMER_H_INCLUDED__
@@ -33,7 +33,7 @@ struct usart_stream_info_t usart_stream_p0 =
 				usart_tx_buff,
 				sizeof(usart_tx_buff)
 			}
-		},							// fifo
+		},							// ring
 	},								// struct vsf_stream_t stream_tx;
 	{
 		{
@@ -41,7 +41,7 @@ struct usart_stream_info_t usart_stream_p0 =
 				usart_rx_buff,
 				sizeof(usart_rx_buff)
 			}
-		},							// fifo
+		},							// ring
 	}								// struct vsf_stream_t stream_rx;
 };
 
@@ -124,7 +124,7 @@ vsf_err_t usart_receive(uint8_t index, uint8_t *buf, uint16_t len)
 
 vsf_err_t usart_status(uint8_t index, struct usart_status_t *status)
 {
-	struct vsf_fifo_t *fifo_tx, *fifo_rx;
+	struct vsf_ring_t *ring_tx, *ring_rx;
 	
 	switch (index)
 	{
@@ -134,12 +134,12 @@ vsf_err_t usart_status(uint8_t index, struct usart_status_t *status)
 			return VSFERR_INVALID_PTR;
 		}
 		
-		fifo_tx = &usart_stream_p0.stream_tx.fifo;
-		fifo_rx = &usart_stream_p0.stream_rx.fifo;
-		status->tx_buff_avail = vsf_fifo_get_avail_length(fifo_tx);
-		status->tx_buff_size = vsf_fifo_get_data_length(fifo_tx);
-		status->rx_buff_avail = vsf_fifo_get_avail_length(fifo_rx);
-		status->rx_buff_size = vsf_fifo_get_data_length(fifo_rx);
+		ring_tx = &usart_stream_p0.stream_tx.ring;
+		ring_rx = &usart_stream_p0.stream_rx.ring;
+		status->tx_buff_avail = vsf_ring_get_avail_length(ring_tx);
+		status->tx_buff_size = vsf_ring_get_data_length(ring_tx);
+		status->rx_buff_avail = vsf_ring_get_avail_length(ring_rx);
+		status->rx_buff_size = vsf_ring_get_data_length(ring_rx);
 		return VSFERR_NONE;
 	default:
 		return VSFERR_NOT_SUPPORT;
@@ -303,6 +303,13 @@ vsf_err_t nuc400_tickclk_set_callback(void (*callback)(void*), void *param)
 	return VSFERR_NONE;
 }
 
+// tickless is not supported, tick interrupt is always periodic
+vsf_err_t nuc400_tickclk_set_interval(uint32_t ticks)
+{
+	REFERENCE_PARAMETER(ticks);
+	return VSFERR_NOT_SUPPORT;
+}
+
 vsf_err_t nuc400_tickclk_init(void)
 {
 	nuc400_tickcnt = 0;
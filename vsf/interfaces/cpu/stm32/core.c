@@ -283,10 +283,17 @@ vsf_err_t stm32_delay_delayms(uint16_t ms)
 
 // tickclk
 #define TICKCLK_TIM							TIM5
+// TICKCLK_TIM is free-running, and tick interrupt is generated by compare
+// channel 1, so that the next tick interrupt can be delayed in tickless mode
+// tick count is always calculated from the counter, so no tick is lost
+#define TICKCLK_COUNT_PER_TICK				4
+#define TICKCLK_MAX_INTERVAL				(0xFFFF / TICKCLK_COUNT_PER_TICK - 1)
 
 static void (*stm32_tickclk_callback)(void *param) = NULL;
 static void *stm32_tickclk_param = NULL;
 static uint32_t stm32_tickcnt = 0;
+// counter value of the last tick accounted in stm32_tickcnt
+static uint16_t stm32_tickclk_last = 0;
 vsf_err_t stm32_tickclk_start(void)
 {
 	TICKCLK_TIM->CR1 |= TIM_CR1_CEN;
@@ -299,9 +306,40 @@ vsf_err_t stm32_tickclk_stop(void)
 	return VSFERR_NONE;
 }
 
+// ticks elapsed but not accounted in stm32_tickcnt
+static uint32_t stm32_tickclk_get_elapsed(void)
+{
+	return (uint16_t)(TICKCLK_TIM->CNT - stm32_tickclk_last) /
+				TICKCLK_COUNT_PER_TICK;
+}
+
+static void stm32_tickclk_update(void)
+{
+	uint32_t elapsed = stm32_tickclk_get_elapsed();
+	
+	stm32_tickcnt += elapsed;
+	stm32_tickclk_last += elapsed * TICKCLK_COUNT_PER_TICK;
+}
+
+// MUST be called after stm32_tickclk_update
+static void stm32_tickclk_set_compare(uint32_t interval)
+{
+	uint16_t compare = stm32_tickclk_last + interval * TICKCLK_COUNT_PER_TICK;
+	
+	TICKCLK_TIM->CCR1 = compare;
+	// if the counter passed the compare value before it's written,
+	// generate the compare event by software, or it will be delayed
+	// until the counter wraps around
+	if ((uint16_t)(TICKCLK_TIM->CNT - stm32_tickclk_last) >=
+			(uint16_t)(compare - stm32_tickclk_last))
+	{
+		TICKCLK_TIM->EGR = TIM_EGR_CC1G;
+	}
+}
+
 static uint32_t stm32_tickclk_get_count_local(void)
 {
-	return stm32_tickcnt;
+	return stm32_tickcnt + stm32_tickclk_get_elapsed();
 }
 
 uint32_t stm32_tickclk_get_count(void)
@@ -317,37 +355,62 @@ uint32_t stm32_tickclk_get_count(void)
 
 ROOTFUNC void TIM5_IRQHandler(void)
 {
-	stm32_tickcnt++;
+	TICKCLK_TIM->SR = ~TIM_SR_CC1IF;
+	stm32_tickclk_update();
+	// interval set by stm32_tickclk_set_interval is only for one interrupt
+	stm32_tickclk_set_compare(1);
 	if (stm32_tickclk_callback != NULL)
 	{
 		stm32_tickclk_callback(stm32_tickclk_param);
 	}
-	TICKCLK_TIM->SR = ~TIM_SR_UIF;
 }
 
 vsf_err_t stm32_tickclk_set_callback(void (*callback)(void*), void *param)
 {
-	TICKCLK_TIM->DIER &= ~TIM_DIER_UIE;
+	TICKCLK_TIM->DIER &= ~TIM_DIER_CC1IE;
 	stm32_tickclk_callback = callback;
 	stm32_tickclk_param = param;
-	TICKCLK_TIM->DIER |= TIM_DIER_UIE;
+	TICKCLK_TIM->DIER |= TIM_DIER_CC1IE;
+	return VSFERR_NONE;
+}
+
+vsf_err_t stm32_tickclk_set_interval(uint32_t ticks)
+{
+	if (ticks < 1)
+	{
+		ticks = 1;
+	}
+	else if (ticks > TICKCLK_MAX_INTERVAL)
+	{
+		ticks = TICKCLK_MAX_INTERVAL;
+	}
+	
+	TICKCLK_TIM->DIER &= ~TIM_DIER_CC1IE;
+	stm32_tickclk_update();
+	stm32_tickclk_set_compare(ticks);
+	TICKCLK_TIM->DIER |= TIM_DIER_CC1IE;
 	return VSFERR_NONE;
 }
 
 vsf_err_t stm32_tickclk_init(void)
 {
 	stm32_tickcnt = 0;
+	stm32_tickclk_last = 0;
 	RCC->APB1ENR |= RCC_APB1ENR_TIM5EN;
 	RCC->APB1RSTR |= RCC_APB1RSTR_TIM5RST;
 	RCC->APB1RSTR &= ~RCC_APB1RSTR_TIM5RST;
 	
-	// TIM5 generate 1ms event
+	// TIM5 count TICKCLK_COUNT_PER_TICK in 1ms, compare channel 1 generate
+	// 1ms event by default
 	TICKCLK_TIM->CR1 &= 0x03FF;
-	TICKCLK_TIM->ARR = stm32_info.apb1_freq_hz / 2 / 1000;
-	TICKCLK_TIM->PSC = 1;
+	TICKCLK_TIM->ARR = 0xFFFF;
+	TICKCLK_TIM->PSC = stm32_info.apb1_freq_hz / 1000 /
+							TICKCLK_COUNT_PER_TICK - 1;
 	TICKCLK_TIM->RCR = 0;
+	TICKCLK_TIM->CCR1 = TICKCLK_COUNT_PER_TICK;
 	TICKCLK_TIM->EGR |= TIM_EGR_UG;
-	TICKCLK_TIM->DIER |= TIM_DIER_UIE;
+	TICKCLK_TIM->SR = 0;
+	TICKCLK_TIM->DIER |= TIM_DIER_CC1IE;
 	NVIC->IP[TIM5_IRQn] = 0xFF;
 	NVIC->ISER[TIM5_IRQn >> 0x05] = 1UL << (TIM5_IRQn & 0x1F);
 	
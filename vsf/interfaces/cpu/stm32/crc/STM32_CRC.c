@@ -0,0 +1,87 @@
+#include "app_type.h"
+#include "compiler.h"
+#include "interfaces.h"
+
+#define STM32_CRC_POLY					((uint32_t)0x04C11DB7)
+#define STM32_CRC_INIT					((uint32_t)0xFFFFFFFF)
+
+#if IFS_CRC_EN
+
+#include "STM32_CRC.h"
+
+#define STM32_CRC_NUM					1
+
+vsf_err_t stm32_crc_init(uint8_t index)
+{
+	switch (index)
+	{
+	case 0:
+		RCC->AHBENR |= RCC_AHBENR_CRCEN;
+		return VSFERR_NONE;
+	default:
+		return VSFERR_NOT_SUPPORT;
+	}
+}
+
+vsf_err_t stm32_crc_fini(uint8_t index)
+{
+	switch (index)
+	{
+	case 0:
+		RCC->AHBENR &= ~RCC_AHBENR_CRCEN;
+		return VSFERR_NONE;
+	default:
+		return VSFERR_NOT_SUPPORT;
+	}
+}
+
+uint32_t stm32_crc_calc(uint8_t index, uint32_t crc, uint32_t *buff,
+						uint32_t num, bool reflect)
+{
+	uint8_t i;
+	
+#if __VSF_DEBUG__
+	if (index >= STM32_CRC_NUM)
+	{
+		return crc;
+	}
+#endif
+	
+	if (reflect)
+	{
+		crc = __RBIT(crc);
+	}
+	
+	// DR can only be reset to STM32_CRC_INIT, to start from crc, run crc
+	// 		backward for 32 bits and feed the result as the first word
+	CRC->CR = CRC_CR_RESET;
+	if (crc != STM32_CRC_INIT)
+	{
+		for (i = 0; i < 32; i++)
+		{
+			crc = (crc & 1) ? ((crc ^ STM32_CRC_POLY) >> 1) | 0x80000000 :
+								crc >> 1;
+		}
+		CRC->DR = crc ^ STM32_CRC_INIT;
+	}
+	
+	// the first byte in memory is the first byte to process
+	if (reflect)
+	{
+		while (num--)
+		{
+			CRC->DR = __RBIT(*buff++);
+		}
+		return __RBIT(CRC->DR);
+	}
+	else
+	{
+		while (num--)
+		{
+			CRC->DR = __REV(*buff++);
+		}
+		return CRC->DR;
+	}
+}
+
+#endif
@@ -0,0 +1,4 @@
+vsf_err_t stm32_crc_init(uint8_t index);
+vsf_err_t stm32_crc_fini(uint8_t index);
+uint32_t stm32_crc_calc(uint8_t index, uint32_t crc, uint32_t *buff,
+						uint32_t num, bool reflect);
@@ -157,6 +157,13 @@ vsf_err_t stm32f4_tickclk_set_callback(void (*callback)(void*), void *param)
 	return VSFERR_NONE;
 }
 
+// tickless is not supported, tick interrupt is always periodic
+vsf_err_t stm32f4_tickclk_set_interval(uint32_t ticks)
+{
+	REFERENCE_PARAMETER(ticks);
+	return VSFERR_NOT_SUPPORT;
+}
+
 vsf_err_t stm32f4_tickclk_init(void)
 {
 	stm32f4_tickcnt = 0;
@@ -73,6 +73,14 @@ const struct interfaces_info_t core_interfaces =
 		CORE_CLKO_DISABLE(__TARGET_CHIP__),
 	}
 #endif
+#if IFS_CRC_EN
+	// crc
+	,{
+		CORE_CRC_INIT(__TARGET_CHIP__),
+		CORE_CRC_FINI(__TARGET_CHIP__),
+		CORE_CRC_CALC(__TARGET_CHIP__),
+	}
+#endif
 #if IFS_GPIO_EN
 	,{
 		// gpio
@@ -298,6 +306,7 @@ const struct interfaces_info_t core_interfaces =
 		CORE_TICKCLK_STOP(__TARGET_CHIP__),
 		CORE_TICKCLK_GET_COUNT(__TARGET_CHIP__),
 		CORE_TICKCLK_SET_CALLBACK(__TARGET_CHIP__),
+		CORE_TICKCLK_SET_INTERVAL(__TARGET_CHIP__),
 	}
 	,{
 		// delay
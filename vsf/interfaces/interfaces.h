@@ -173,6 +173,30 @@ vsf_err_t CORE_CLKO_DISABLE(__TARGET_CHIP__)(uint8_t index);
 
 #endif
 
+#if IFS_CRC_EN
+
+// hardware CRC unit with poly 0x04C11DB7, MSB first, 32-bit word input
+// crc is the register to start from, reflect is for LSB first model
+// 		with reflected register
+struct interface_crc_t
+{
+	vsf_err_t (*init)(uint8_t index);
+	vsf_err_t (*fini)(uint8_t index);
+	uint32_t (*calc)(uint8_t index, uint32_t crc, uint32_t *buff,
+						uint32_t num, bool reflect);
+};
+
+#define CORE_CRC_INIT(m)				__CONNECT(m, _crc_init)
+#define CORE_CRC_FINI(m)				__CONNECT(m, _crc_fini)
+#define CORE_CRC_CALC(m)				__CONNECT(m, _crc_calc)
+
+vsf_err_t CORE_CRC_INIT(__TARGET_CHIP__)(uint8_t index);
+vsf_err_t CORE_CRC_FINI(__TARGET_CHIP__)(uint8_t index);
+uint32_t CORE_CRC_CALC(__TARGET_CHIP__)(uint8_t index, uint32_t crc,
+								uint32_t *buff, uint32_t num, bool reflect);
+
+#endif
+
 #if IFS_USART_EN
 
 #define CORE_USART_MODE0(m)			__CONNECT(m, _USART_MODE0)
@@ -454,6 +478,10 @@ struct interface_tickclk_t
 	vsf_err_t (*stop)(void);
 	uint32_t (*get_count)(void);
 	vsf_err_t (*set_callback)(void (*callback)(void *param), void *param);
+	// delay the next tick interrupt for ticks, used for tickless idle
+	// tick count is still updated, and the tick interrupt will be periodic
+	// 		again after the delayed interrupt
+	vsf_err_t (*set_interval)(uint32_t ticks);
 };
 
 #define CORE_TICKCLK_INIT(m)			__CONNECT(m, _tickclk_init)
@@ -462,6 +490,7 @@ struct interface_tickclk_t
 #define CORE_TICKCLK_STOP(m)			__CONNECT(m, _tickclk_stop)
 #define CORE_TICKCLK_GET_COUNT(m)		__CONNECT(m, _tickclk_get_count)
 #define CORE_TICKCLK_SET_CALLBACK(m)	__CONNECT(m, _tickclk_set_callback)
+#define CORE_TICKCLK_SET_INTERVAL(m)	__CONNECT(m, _tickclk_set_interval)
 
 vsf_err_t CORE_TICKCLK_INIT(__TARGET_CHIP__)(void);
 vsf_err_t CORE_TICKCLK_FINI(__TARGET_CHIP__)(void);
@@ -470,6 +499,7 @@ vsf_err_t CORE_TICKCLK_STOP(__TARGET_CHIP__)(void);
 uint32_t CORE_TICKCLK_GET_COUNT(__TARGET_CHIP__)(void);
 vsf_err_t CORE_TICKCLK_SET_CALLBACK(__TARGET_CHIP__)(
 					void (*callback)(void *param), void *param);
+vsf_err_t CORE_TICKCLK_SET_INTERVAL(__TARGET_CHIP__)(uint32_t ticks);
 
 #if IFS_IIC_EN
 
@@ -1145,6 +1175,9 @@ struct interfaces_info_t
 #if IFS_CLKO_EN
 	struct interface_clko_t clko;
 #endif
+#if IFS_CRC_EN
+	struct interface_crc_t crc;
+#endif
 #if IFS_GPIO_EN
 	struct interface_gpio_t gpio;
 #endif
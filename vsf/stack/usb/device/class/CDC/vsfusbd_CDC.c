@@ -21,7 +21,7 @@ static vsf_err_t vsfusbd_CDCData_OUT_hanlder(struct vsfusbd_device_t *device,
 	int8_t iface = config->ep_OUT_iface_map[ep];
 	struct vsfusbd_CDC_param_t *param = NULL;
 	uint16_t pkg_size, ep_size;
-	uint8_t buffer[64];
+	uint8_t bounce[64], *buffer;
 	struct vsf_buffer_t rx_buffer;
 	
 	if (iface < 0)
@@ -40,11 +40,21 @@ static vsf_err_t vsfusbd_CDCData_OUT_hanlder(struct vsfusbd_device_t *device,
 	{
 		return VSFERR_FAIL;
 	}
-	device->drv->ep.read_OUT_buffer(ep, buffer, pkg_size);
 	
-	rx_buffer.buffer = buffer;
-	rx_buffer.size = pkg_size;
-	stream_tx(param->stream_rx, &rx_buffer);
+	// read the packet into the stream directly if the span is large enough,
+	// 		else bounce it to split it at the wrap of the ring
+	if (stream_get_wbuf(param->stream_rx, &buffer) >= pkg_size)
+	{
+		device->drv->ep.read_OUT_buffer(ep, buffer, pkg_size);
+		stream_commit_write(param->stream_rx, pkg_size);
+	}
+	else
+	{
+		device->drv->ep.read_OUT_buffer(ep, bounce, pkg_size);
+		rx_buffer.buffer = bounce;
+		rx_buffer.size = pkg_size;
+		stream_tx(param->stream_rx, &rx_buffer);
+	}
 	
 	if (stream_get_free_size(param->stream_rx) < ep_size)
 	{
@@ -65,9 +75,8 @@ static vsf_err_t vsfusbd_CDCData_IN_hanlder(struct vsfusbd_device_t *device,
 	int8_t iface = config->ep_IN_iface_map[ep];
 	struct vsfusbd_CDC_param_t *param = NULL;
 	uint16_t pkg_size;
-	uint8_t buffer[64];
+	uint8_t *buffer;
 	uint32_t tx_data_length;
-	struct vsf_buffer_t tx_buffer;
 	
 	if (iface < 0)
 	{
@@ -80,13 +89,17 @@ static vsf_err_t vsfusbd_CDCData_IN_hanlder(struct vsfusbd_device_t *device,
 	}
 	
 	pkg_size = device->drv->ep.get_IN_epsize(ep);
-	tx_buffer.buffer = buffer;
-	tx_buffer.size = pkg_size;
-	tx_data_length = stream_rx(param->stream_tx, &tx_buffer);
+	// data at the wrap of the ring is sent in a short packet
+	tx_data_length = stream_get_rbuf(param->stream_tx, &buffer);
+	if (tx_data_length > pkg_size)
+	{
+		tx_data_length = pkg_size;
+	}
 	if (tx_data_length)
 	{
 		device->drv->ep.write_IN_buffer(ep, buffer, tx_data_length);
 		device->drv->ep.set_IN_count(ep, tx_data_length);
+		stream_commit_read(param->stream_tx, tx_data_length);
 	}
 	else
 	{
@@ -100,14 +113,14 @@ static void vsfusbd_CDCData_streamtx_callback_on_in_int(void *p)
 {
 	struct vsfusbd_CDC_param_t *param = (struct vsfusbd_CDC_param_t *)p;
 	
-	vsfsm_post_evt_pending(&param->iface->sm, VSFUSBD_CDC_EVT_STREAMTX_ONIN);
+	vsfsm_post_evt_coalesce(&param->iface->sm, VSFUSBD_CDC_EVT_STREAMTX_ONIN);
 }
 
 static void vsfusbd_CDCData_streamrx_callback_on_out_int(void *p)
 {
 	struct vsfusbd_CDC_param_t *param = (struct vsfusbd_CDC_param_t *)p;
 	
-	vsfsm_post_evt_pending(&param->iface->sm, VSFUSBD_CDC_EVT_STREAMRX_ONOUT);
+	vsfsm_post_evt_coalesce(&param->iface->sm, VSFUSBD_CDC_EVT_STREAMRX_ONOUT);
 }
 
 static void vsfusbd_CDCData_streamtx_callback_on_txconn(void *p)
@@ -155,7 +168,7 @@ vsfusbd_CDCData_evt_handler(struct vsfsm_t *sm, vsfsm_evt_t evt)
 	case VSFUSBD_CDC_EVT_STREAMRX_ONCONN:
 		vsfusbd_set_OUT_handler(device, param->ep_out,
 										vsfusbd_CDCData_OUT_hanlder);
-		vsfsm_post_evt(sm, VSFUSBD_CDC_EVT_STREAMRX_ONOUT);
+		vsfsm_post_evt_coalesce(sm, VSFUSBD_CDC_EVT_STREAMRX_ONOUT);
 		break;
 	case VSFUSBD_CDC_EVT_STREAMTX_ONIN:
 		if (!param->in_enable)
@@ -197,6 +210,17 @@ static vsf_err_t vsfusbd_CDCData_class_init(uint8_t iface,
 	param->iface = ifs;
 	param->device = device;
 	ifs->sm.user_data = (void*)param;
+#if VSFSM_CFG_PRIORITY_EN
+	ifs->sm.priority = VSFSM_PRIORITY_NORMAL;
+#endif
+#if VSFSM_CFG_MAILBOX_EN
+	param->mailbox.buffer = param->mailbox_buffer;
+	param->mailbox.size = dimof(param->mailbox_buffer);
+	ifs->sm.mailbox = &param->mailbox;
+#endif
+#if VSFSM_CFG_PROFILE_EN
+	vsfsm_profile_register(&ifs->sm, "cdc");
+#endif
 	return vsfsm_init(&ifs->sm);
 }
 
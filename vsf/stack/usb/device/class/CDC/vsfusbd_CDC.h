@@ -3,6 +3,7 @@
 
 #include "tool/buffer/buffer.h"
 #include "dal/stream/stream.h"
+#include "framework/vsfsm/vsfsm.h"
 
 enum usb_CDC_req_t
 {
@@ -38,6 +39,11 @@ struct vsfusbd_CDC_param_t
 	// no need to initialize below by user
 	bool out_enable;
 	bool in_enable;
+#if VSFSM_CFG_MAILBOX_EN
+	// every event of CDC is pending at most once in the mailbox
+	struct vsfsm_mailbox_t mailbox;
+	vsfsm_evt_t mailbox_buffer[4];
+#endif
 	
 	struct vsfusbd_device_t *device;
 	struct vsfusbd_iface_t *iface;
@@ -189,6 +189,7 @@ vsfusbd_HID_evt_handler(struct vsfsm_t *sm, vsfsm_evt_t evt)
 		param->timer4ms.sm = &param->iface->sm;
 		param->timer4ms.evt = VSFUSBD_HID_EVT_TIMER4MS;
 		param->timer4ms.interval = 4;
+		param->timer4ms.mode = VSFTIMER_MODE_PHASE_LOCKED;
 		vsftimer_register(&param->timer4ms);
 		break;
 	case VSFUSBD_HID_EVT_TIMER4MS:
@@ -227,7 +228,24 @@ vsfusbd_HID_evt_handler(struct vsfsm_t *sm, vsfsm_evt_t evt)
 							(report->idle_cnt >= report->idle))))
 				{
 					report->idle_cnt = 0;
-					transact->tbuffer.buffer = report->buffer;
+					if (1 == param->num_of_INPUT_report)
+					{
+						transact->buflist = NULL;
+						transact->tbuffer.buffer = report->buffer;
+					}
+					else
+					{
+						// report id is the first byte of numbered reports
+						param->input_report_id = report->id;
+						param->input_report_list[0].buffer.buffer =
+												&param->input_report_id;
+						param->input_report_list[0].buffer.size = 1;
+						param->input_report_list[0].next =
+												&param->input_report_list[1];
+						param->input_report_list[1].buffer = report->buffer;
+						param->input_report_list[1].next = NULL;
+						transact->buflist = param->input_report_list;
+					}
 					transact->callback.callback = vsfusbd_HID_INREPORT_callback;
 					transact->callback.param = param;
 					vsfusbd_ep_send_nb(device, ep);
@@ -74,6 +74,9 @@ struct vsfusbd_HID_param_t
 	
 	enum vsfusbd_HID_output_state_t output_state;
 	uint8_t current_output_report_id;
+	// report id prepended to input report without copying the report
+	uint8_t input_report_id;
+	struct vsf_buffer_list_t input_report_list[2];
 	
 	uint8_t num_of_INPUT_report;
 	uint8_t num_of_OUTPUT_report;
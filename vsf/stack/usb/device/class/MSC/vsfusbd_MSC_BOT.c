@@ -11,10 +11,78 @@
 #define VSFUSBD_MSCBOT_STALL_BOTH				\
 							VSFUSBD_MSCBOT_STALL_IN | VSFUSBD_MSCBOT_STALL_OUT
 
-static struct vsf_buffer_t *vsfusbd_MSCBOT_GetBuffer(
+static void vsfusbd_MSCBOT_PushPage(struct vsfusbd_MSCBOT_param_t *param,
+										struct vsf_rcbuf_t *page)
+{
+	page->next = NULL;
+	if (NULL == param->ready_tail)
+	{
+		param->ready_head = page;
+	}
+	else
+	{
+		param->ready_tail->next = page;
+	}
+	param->ready_tail = page;
+}
+
+static struct vsf_rcbuf_t *vsfusbd_MSCBOT_PopPage(
 		struct vsfusbd_MSCBOT_param_t *param)
 {
-	return &param->page_buffer[++param->tick_tock & 1];
+	struct vsf_rcbuf_t *page = param->ready_head;
+	
+	if (page != NULL)
+	{
+		param->ready_head = page->next;
+		if (NULL == param->ready_head)
+		{
+			param->ready_tail = NULL;
+		}
+	}
+	return page;
+}
+
+static void vsfusbd_MSCBOT_FreePages(struct vsfusbd_MSCBOT_param_t *param)
+{
+	vsf_rcbuf_release(param->usb_page);
+	vsf_rcbuf_release(param->scsi_page);
+	param->usb_page = param->scsi_page = NULL;
+	while (param->ready_head != NULL)
+	{
+		vsf_rcbuf_release(vsfusbd_MSCBOT_PopPage(param));
+	}
+}
+
+// endpoint takes its own reference of the page until the transfer completes
+static bool vsfusbd_MSCBOT_SetUsbPage(struct vsfusbd_MSCBOT_param_t *param,
+										struct vsf_rcbuf_t *page)
+{
+	if (page != NULL)
+	{
+		param->usb_page = vsf_rcbuf_take(page);
+		param->tbuffer.buffer = page->buffer;
+	}
+	return page != NULL;
+}
+
+// allocate a page to be received from usb, the reference from the pool is
+// 		owned by the ready queue
+static bool vsfusbd_MSCBOT_AllocUsbPage(struct vsfusbd_MSCBOT_param_t *param)
+{
+	struct vsf_rcbuf_t *page = vsf_rcbuf_alloc(&param->page_pool);
+	
+	if (page != NULL)
+	{
+		vsfusbd_MSCBOT_PushPage(param, page);
+	}
+	return vsfusbd_MSCBOT_SetUsbPage(param, page);
+}
+
+// for IN, oldest page in ready queue can be sent after SCSI reads it
+static bool vsfusbd_MSCBOT_GetInPage(struct vsfusbd_MSCBOT_param_t *param)
+{
+	return (param->cur_usb_page < param->cur_scsi_page) &&
+			vsfusbd_MSCBOT_SetUsbPage(param, param->ready_head);
 }
 
 static uint16_t vsfusbd_MSCBOT_GetInPkgSize(struct interface_usbd_t *drv, 
@@ -41,6 +109,7 @@ static vsf_err_t vsfusbd_MSCBOT_SendCSW(struct vsfusbd_device_t *device,
 	uint8_t CSW_buffer[USBMSC_CSW_SIZE];
 	
 	param->poll = false;
+	vsfusbd_MSCBOT_FreePages(param);
 	
 	SET_LE_U32(&CSW_buffer[0], USBMSC_CSW_SIGNATURE);
 	SET_LE_U32(&CSW_buffer[4], param->CBW.dCBWTag);
@@ -126,21 +195,19 @@ static vsf_err_t vsfusbd_MSCBOT_IN_hanlder(struct vsfusbd_device_t *device,
 		}
 		
 		param->tbuffer.position = 0;
+		vsf_rcbuf_release(param->usb_page);
+		param->usb_page = NULL;
+		vsf_rcbuf_release(vsfusbd_MSCBOT_PopPage(param));
 		if (++param->cur_usb_page >= param->page_num)
 		{
 			return vsfusbd_MSCBOT_SendCSW(device, param);
 		}
 		
-		if (param->cur_scsi_page > param->cur_usb_page)
+		// if next page is not ready, poll will restart IN when it's ready
+		if (vsfusbd_MSCBOT_GetInPage(param))
 		{
-			param->idle = false;
-			param->tbuffer.buffer = *vsfusbd_MSCBOT_GetBuffer(param);
 			return vsfusbd_MSCBOT_IN_hanlder(device, ep);
 		}
-		else
-		{
-			param->idle = true;
-		}
 		break;
 	default:
 		return VSFERR_FAIL;
@@ -196,8 +263,11 @@ static vsf_err_t vsfusbd_MSCBOT_OUT_hanlder(struct vsfusbd_device_t *device,
 		}
 		param->page_size = param->page_num = 0;
 		param->cur_handlers = NULL;
-		param->tbuffer.buffer = *vsfusbd_MSCBOT_GetBuffer(param);
 		param->dCSWStatus = USBMSC_CSW_OK;
+		if (!vsfusbd_MSCBOT_AllocUsbPage(param))
+		{
+			return vsfusbd_MSCBOT_ErrHandler(device, param, USBMSC_CSW_FAIL);
+		}
 		if (SCSI_Handle(param->cur_handlers, lun_info, 
 					param->CBW.CBWCB, &param->tbuffer.buffer, &param->page_size, 
 					&param->page_num))
@@ -240,15 +310,18 @@ static vsf_err_t vsfusbd_MSCBOT_OUT_hanlder(struct vsfusbd_device_t *device,
 				}
 				else
 				{
+					// pages will be read by SCSI_IO in poll
+					vsf_rcbuf_release(param->usb_page);
+					param->usb_page = NULL;
+					vsf_rcbuf_release(vsfusbd_MSCBOT_PopPage(param));
 					param->poll = true;
-					param->idle = true;
 				}
 			}
 			else
 			{
+				// usb_page is used to receive the first page
 				param->bot_status = VSFUSBD_MSCBOT_STATUS_OUT;
 				param->poll = true;
-				param->idle = false;
 				return drv->ep.enable_OUT(param->ep_out);
 			}
 		}
@@ -278,18 +351,17 @@ static vsf_err_t vsfusbd_MSCBOT_OUT_hanlder(struct vsfusbd_device_t *device,
 				return VSFERR_NONE;
 			}
 			
+			// page is left in ready queue for SCSI
 			param->tbuffer.position = 0;
-			param->cur_usb_page++;
-			if ((param->cur_usb_page - param->cur_scsi_page) < 2)
+			vsf_rcbuf_release(param->usb_page);
+			param->usb_page = NULL;
+			
+			// if no free page, poll will restart OUT when SCSI releases one
+			if ((++param->cur_usb_page < param->page_num) &&
+				vsfusbd_MSCBOT_AllocUsbPage(param))
 			{
-				param->idle = false;
-				param->tbuffer.buffer = *vsfusbd_MSCBOT_GetBuffer(param);
 				drv->ep.enable_OUT(param->ep_out);
 			}
-			else
-			{
-				param->idle = true;
-			}
 		}
 		else
 		{
@@ -331,9 +403,14 @@ static vsf_err_t vsfusbd_MSCBOT_class_init(uint8_t iface,
 		return VSFERR_FAIL;
 	}
 	
-	param->idle = true;
 	param->poll = false;
 	param->bot_status = VSFUSBD_MSCBOT_STATUS_IDLE;
+	param->usb_page = param->scsi_page = NULL;
+	param->ready_head = param->ready_tail = NULL;
+	if (vsf_rcbuf_pool_init(&param->page_pool))
+	{
+		return VSFERR_FAIL;
+	}
 	for (i = 0; i <= param->max_lun; i++)
 	{
 		SCSI_Init(&param->lun_info[i]);
@@ -349,6 +426,7 @@ static vsf_err_t vsfusbd_MSCBOT_class_poll(uint8_t iface,
 	struct vsfusbd_MSCBOT_param_t *param = 
 		(struct vsfusbd_MSCBOT_param_t *)config->iface[iface].protocol_param;
 	enum vsfusbd_MSCBOT_status_t bot_status = param->bot_status;
+	struct vsf_rcbuf_t *page = NULL;
 	uint8_t i;
 	
 	if (NULL == param)
@@ -365,19 +443,43 @@ static vsf_err_t vsfusbd_MSCBOT_class_poll(uint8_t iface,
 	{
 		return VSFERR_NONE;
 	}
-	if (((VSFUSBD_MSCBOT_STATUS_IN == bot_status) && 
-			(param->cur_scsi_page < param->page_num) && 
-			((param->cur_scsi_page - param->cur_usb_page) < 2)) || 
-		((VSFUSBD_MSCBOT_STATUS_OUT == bot_status) && 
-			(param->cur_scsi_page < param->page_num) && 
-			(param->cur_usb_page > param->cur_scsi_page)))
+	if (param->cur_scsi_page >= param->page_num)
+	{
+		return VSFERR_NONE;
+	}
+	
+	// for IN, SCSI reads into a free page queued to the ready queue
+	// for OUT, SCSI writes the oldest page received from usb
+	// SCSI takes its own reference of the page until SCSI_IO completes
+	if (NULL == param->scsi_page)
+	{
+		if (VSFUSBD_MSCBOT_STATUS_IN == bot_status)
+		{
+			page = vsf_rcbuf_alloc(&param->page_pool);
+			if (page != NULL)
+			{
+				vsfusbd_MSCBOT_PushPage(param, page);
+			}
+		}
+		else if ((VSFUSBD_MSCBOT_STATUS_OUT == bot_status) &&
+				(param->cur_scsi_page < param->cur_usb_page))
+		{
+			page = param->ready_head;
+		}
+		if (page != NULL)
+		{
+			param->scsi_page = vsf_rcbuf_take(page);
+		}
+	}
+	page = param->scsi_page;
+	
+	if (page != NULL)
 	{
 		struct SCSI_LUN_info_t *lun_info = &param->lun_info[param->CBW.bCBWLUN];
-		uint8_t index = (param->tick_tock + 1) & 1;
-		struct vsf_buffer_t *buffer = &param->page_buffer[index];
+		struct vsf_buffer_t buffer = page->buffer;
 		vsf_err_t err;
 		
-		err = SCSI_IO(param->cur_handlers, lun_info, param->CBW.CBWCB, buffer,
+		err = SCSI_IO(param->cur_handlers, lun_info, param->CBW.CBWCB, &buffer,
 						param->cur_scsi_page);
 		if (err != VSFERR_NONE)
 		{
@@ -389,26 +491,27 @@ static vsf_err_t vsfusbd_MSCBOT_class_poll(uint8_t iface,
 			return vsfusbd_MSCBOT_ErrHandler(device, param, USBMSC_CSW_FAIL);
 		}
 		param->cur_scsi_page++;
+		vsf_rcbuf_release(param->scsi_page);
+		param->scsi_page = NULL;
 		
 		if (VSFUSBD_MSCBOT_STATUS_IN == bot_status)
 		{
-			if (param->idle)
+			if ((NULL == param->usb_page) && vsfusbd_MSCBOT_GetInPage(param))
 			{
-				param->idle = false;
-				param->tbuffer.buffer = *vsfusbd_MSCBOT_GetBuffer(param);
 				vsfusbd_MSCBOT_IN_hanlder((void *)device, param->ep_in);
 			}
 		}
 		else if (VSFUSBD_MSCBOT_STATUS_OUT == bot_status)
 		{
+			vsf_rcbuf_release(vsfusbd_MSCBOT_PopPage(param));
 			if (param->cur_scsi_page >= param->page_num)
 			{
 				return vsfusbd_MSCBOT_SendCSW(device, param);
 			}
-			if (param->idle)
+			if ((NULL == param->usb_page) && 
+				(param->cur_usb_page < param->page_num) && 
+				vsfusbd_MSCBOT_AllocUsbPage(param))
 			{
-				param->idle = false;
-				param->tbuffer.buffer = *vsfusbd_MSCBOT_GetBuffer(param);
 				return drv->ep.enable_OUT(param->ep_out);
 			}
 		}
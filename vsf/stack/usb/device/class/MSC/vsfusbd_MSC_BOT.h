@@ -61,17 +61,23 @@ struct vsfusbd_MSCBOT_param_t
 	struct SCSI_LUN_info_t *lun_info;
 	struct SCSI_handler_t *user_handlers;
 	
-	// tick-tock operation
 	// buffer size should be the largest one of all LUNs
-	struct vsf_buffer_t page_buffer[2];
+	// 2 buffers for tick-tock operation, more buffers for deeper pipeline
+	struct vsf_rcbuf_pool_t page_pool;
 	
 	// no need to initialize below by user
-	uint8_t tick_tock;
-	volatile bool idle, poll;
+	volatile bool poll;
 	struct SCSI_handler_t *cur_handlers;
 	struct USBMSC_CBW_t CBW;
 	uint8_t dCSWStatus;
 	struct vsf_transaction_buffer_t tbuffer;
+	// usb_page is the page on the endpoint, scsi_page is the page in SCSI_IO
+	// ready queue holds pages of the command in order, from SCSI to usb for
+	// 		IN, and from usb to SCSI for OUT
+	// ready queue, usb_page and scsi_page each own a reference of the page,
+	// 		so a page is shared while it is on the endpoint or in SCSI_IO
+	struct vsf_rcbuf_t *usb_page, *scsi_page;
+	struct vsf_rcbuf_t *ready_head, *ready_tail;
 	uint32_t page_size, page_num, cur_usb_page, cur_scsi_page;
 	volatile enum vsfusbd_MSCBOT_status_t bot_status;
 };
@@ -97,10 +97,25 @@ vsf_err_t vsfusbd_set_OUT_handler(struct vsfusbd_device_t *device,
 	return VSFERR_NONE;
 }
 
-static uint8_t* vsfusbd_data_io(struct vsfusbd_transact_t *transact)
+// packets are written to or read from the hardware immediately after being
+// 		bounced, so one bounce buffer is enough for all endpoints
+static uint8_t vsfusbd_sg_buffer[VSFUSBD_CFG_SG_BUFFER_SIZE];
+
+static uint8_t* vsfusbd_data_io(struct vsfusbd_transact_t *transact,
+								uint32_t size)
 {
 	struct vsf_transaction_buffer_t *tbuffer = &transact->tbuffer;
-	if (tbuffer->buffer.buffer != NULL)
+	if (transact->buflist != NULL)
+	{
+		uint8_t *ptr = vsf_buffer_list_get_ptr(transact->buflist,
+												tbuffer->position, size);
+		if (ptr != NULL)
+		{
+			return ptr;
+		}
+		return (size <= sizeof(vsfusbd_sg_buffer)) ? vsfusbd_sg_buffer : NULL;
+	}
+	else if (tbuffer->buffer.buffer != NULL)
 	{
 		return &tbuffer->buffer.buffer[tbuffer->position];
 	}
@@ -111,19 +126,59 @@ static uint8_t* vsfusbd_data_io(struct vsfusbd_transact_t *transact)
 	return NULL;
 }
 
+static uint8_t* vsfusbd_data_in(struct vsfusbd_transact_t *transact,
+								uint32_t size)
+{
+	uint8_t *ptr = vsfusbd_data_io(transact, size);
+	
+	if (vsfusbd_sg_buffer == ptr)
+	{
+		vsf_buffer_list_read(transact->buflist, transact->tbuffer.position,
+								size, ptr);
+	}
+	return ptr;
+}
+
+static void vsfusbd_data_out_done(struct vsfusbd_transact_t *transact,
+									uint8_t *data, uint32_t size)
+{
+	if (vsfusbd_sg_buffer == data)
+	{
+		vsf_buffer_list_write(transact->buflist, transact->tbuffer.position,
+								size, data);
+	}
+}
+
+static void vsfusbd_transact_init(struct vsfusbd_transact_t *transact)
+{
+	if (transact->buflist != NULL)
+	{
+		transact->tbuffer.buffer.size =
+							vsf_buffer_list_get_size(transact->buflist);
+	}
+	transact->tbuffer.position = 0;
+}
+
 vsf_err_t vsfusbd_ep_receive_nb(struct vsfusbd_device_t *device, uint8_t ep)
 {
 	struct vsfusbd_transact_t *transact = &device->OUT_transact[ep];
 	struct vsf_transaction_buffer_t *tbuffer = &transact->tbuffer;
 	uint16_t size;
 	
+	// packet straddling segments of buflist is bounced in vsfusbd_sg_buffer
+	if ((transact->buflist != NULL) &&
+		(device->drv->ep.get_OUT_epsize(ep) > sizeof(vsfusbd_sg_buffer)))
+	{
+		return VSFERR_NOT_SUPPORT;
+	}
+	
 	transact->pkt.out.isshort = false;
-	tbuffer->position = 0;
+	vsfusbd_transact_init(transact);
 	size = tbuffer->buffer.size;
 	
 	if (size > 0)
 	{
-		if (vsfusbd_data_io(transact) != NULL)
+		if (vsfusbd_data_io(transact, 0) != NULL)
 		{
 			transact->need_poll = false;
 			return device->drv->ep.enable_OUT(ep);
@@ -148,10 +203,15 @@ vsf_err_t vsfusbd_ep_send_nb(struct vsfusbd_device_t *device, uint8_t ep)
 	uint32_t remain_size;
 	uint16_t pkg_size, ep_size;
 	
-	tbuffer->position = 0;
+	ep_size = device->drv->ep.get_IN_epsize(ep);
+	// packet straddling segments of buflist is bounced in vsfusbd_sg_buffer
+	if ((transact->buflist != NULL) && (ep_size > sizeof(vsfusbd_sg_buffer)))
+	{
+		return VSFERR_NOT_SUPPORT;
+	}
 	
+	vsfusbd_transact_init(transact);
 	remain_size = tbuffer->buffer.size;
-	ep_size = device->drv->ep.get_IN_epsize(ep);
 	transact->pkt.in.num = (remain_size + ep_size - 1) / ep_size;
 	if (transact->pkt.in.zlp && !(tbuffer->buffer.size % ep_size))
 	{
@@ -161,7 +221,7 @@ vsf_err_t vsfusbd_ep_send_nb(struct vsfusbd_device_t *device, uint8_t ep)
 	
 	if (pkg_size > 0)
 	{
-		buffer_ptr = vsfusbd_data_io(transact);
+		buffer_ptr = vsfusbd_data_in(transact, pkg_size);
 		transact->need_poll = (NULL == buffer_ptr);
 		if (transact->need_poll)
 		{
@@ -181,7 +241,7 @@ vsf_err_t vsfusbd_ep_send_nb(struct vsfusbd_device_t *device, uint8_t ep)
 		
 		if (pkg_size)
 		{
-			buffer_ptr = vsfusbd_data_io(transact);
+			buffer_ptr = vsfusbd_data_in(transact, pkg_size);
 			if (NULL == buffer_ptr)
 			{
 				return VSFERR_NONE;
@@ -945,16 +1005,17 @@ static vsf_err_t vsfusbd_on_IN_do(struct vsfusbd_device_t *device, uint8_t ep)
 			
 			if (remain_size)
 			{
-				uint8_t *buffer_ptr = vsfusbd_data_io(transact);
+				uint8_t *buffer_ptr;
 				
+				ep_size = device->drv->ep.get_IN_epsize(ep);
+				pkg_size = min(remain_size, ep_size);
+				buffer_ptr = vsfusbd_data_in(transact, pkg_size);
 				transact->need_poll = (NULL == buffer_ptr);
 				if (transact->need_poll)
 				{
 					return VSFERR_NONE;
 				}
 				
-				ep_size = device->drv->ep.get_IN_epsize(ep);
-				pkg_size = min(remain_size, ep_size);
 				device->drv->ep.write_IN_buffer(ep, buffer_ptr, pkg_size);
 				device->drv->ep.set_IN_count(ep, pkg_size);
 				tbuffer->position += pkg_size;
@@ -999,7 +1060,7 @@ static vsf_err_t vsfusbd_on_OUT_do(struct vsfusbd_device_t *device, uint8_t ep)
 		
 		if (pkg_size > 0)
 		{
-			data = vsfusbd_data_io(transact);
+			data = vsfusbd_data_io(transact, pkg_size);
 			if (NULL == data)
 			{
 				// TODO: error processor, maybe stall endpoint
@@ -1007,6 +1068,7 @@ static vsf_err_t vsfusbd_on_OUT_do(struct vsfusbd_device_t *device, uint8_t ep)
 			}
 			
 			device->drv->ep.read_OUT_buffer(ep, data, pkg_size);
+			vsfusbd_data_out_done(transact, data, pkg_size);
 // TODO: notify the upper layer for incoming data
 //			vsfusbd_data_io(device, transact, data);
 			tbuffer->position += pkg_size;
@@ -1030,7 +1092,7 @@ static vsf_err_t vsfusbd_on_OUT_do(struct vsfusbd_device_t *device, uint8_t ep)
 		if (tbuffer->position < tbuffer->buffer.size)
 		{
 			// more data to receive
-			transact->need_poll = (NULL == vsfusbd_data_io(transact));
+			transact->need_poll = (NULL == vsfusbd_data_io(transact, 0));
 			if (!transact->need_poll)
 			{
 				device->drv->ep.enable_OUT(ep);
@@ -1072,6 +1134,7 @@ static void vsfusbd_setup_status_callback(void *param)
 	{
 		device->IN_transact[0].tbuffer.buffer.buffer = NULL;
 		device->IN_transact[0].tbuffer.buffer.size = 0;
+		device->IN_transact[0].buflist = NULL;
 		device->IN_transact[0].pkt.in.zlp = true;
 		device->IN_transact[0].callback.param = device;
 		device->IN_transact[0].callback.callback =
@@ -1083,6 +1146,7 @@ static void vsfusbd_setup_status_callback(void *param)
 	{
 		device->OUT_transact[0].tbuffer.buffer.buffer = NULL;
 		device->OUT_transact[0].tbuffer.buffer.size = 0;
+		device->OUT_transact[0].buflist = NULL;
 		device->OUT_transact[0].callback.param = device;
 		device->OUT_transact[0].callback.callback =
 											vsfusbd_setup_end_callback;
@@ -1393,6 +1457,7 @@ vsfusbd_evt_handler(struct vsfsm_t *sm, vsfsm_evt_t evt)
 				else
 				{
 					device->OUT_transact[0].tbuffer.buffer = buffer;
+					device->OUT_transact[0].buflist = NULL;
 					device->OUT_transact[0].callback.param = device;
 					device->OUT_transact[0].callback.callback =
 											vsfusbd_setup_status_callback;
@@ -1404,6 +1469,7 @@ vsfusbd_evt_handler(struct vsfsm_t *sm, vsfsm_evt_t evt)
 			else
 			{
 				device->IN_transact[0].tbuffer.buffer = buffer;
+				device->IN_transact[0].buflist = NULL;
 				device->IN_transact[0].pkt.in.zlp =
 											buffer.size < request->length;
 				device->IN_transact[0].callback.param = device;
@@ -1490,14 +1556,14 @@ vsfusbd_evt_handler(struct vsfsm_t *sm, vsfsm_evt_t evt)
 						
 						if (remain_size)
 						{
-							uint8_t *buffer = vsfusbd_data_io(transact);
+							uint16_t ep_size =
+											device->drv->ep.get_IN_epsize(ep);
+							uint16_t pkg_size = min(remain_size, ep_size);
+							uint8_t *buffer = vsfusbd_data_in(transact,
+																pkg_size);
 							
 							if (buffer != NULL)
 							{
-								uint16_t ep_size =
-											device->drv->ep.get_IN_epsize(ep);
-								uint16_t pkg_size = min(remain_size, ep_size);
-								
 								device->drv->ep.write_IN_buffer(ep, buffer,
 																pkg_size);
 								device->drv->ep.set_IN_count(ep, pkg_size);
@@ -1524,7 +1590,7 @@ vsfusbd_evt_handler(struct vsfsm_t *sm, vsfsm_evt_t evt)
 									tbuffer->buffer.size - tbuffer->position;
 						
 						if ((remain_size > 0) &&
-							(vsfusbd_data_io(transact) != NULL))
+							(vsfusbd_data_io(transact, 0) != NULL))
 						{
 							device->drv->ep.enable_OUT(ep);
 							transact->need_poll = false;
@@ -1553,6 +1619,13 @@ vsf_err_t vsfusbd_device_init(struct vsfusbd_device_t *device)
 	memset(&device->sm, 0, sizeof(device->sm));
 	device->sm.init_state.evt_handler = vsfusbd_evt_handler;
 	device->sm.user_data = (void*)device;
+#if VSFSM_CFG_PRIORITY_EN
+	// setup and endpoint events MUST not be delayed by other events
+	device->sm.priority = VSFSM_PRIORITY_HIGH;
+#endif
+#if VSFSM_CFG_PROFILE_EN
+	vsfsm_profile_register(&device->sm, "usbd");
+#endif
 	return vsfsm_init(&device->sm);
 }
 
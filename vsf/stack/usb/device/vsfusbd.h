@@ -27,6 +27,13 @@
 
 #include "framework/vsfsm/vsfsm.h"
 
+// bounce buffer for packets across segments of transact buflist, MUST be
+// 		the size of the largest endpoint using buflist, eg. 512 for
+// 		high speed bulk endpoint, larger endpoint is not supported
+#ifndef VSFUSBD_CFG_SG_BUFFER_SIZE
+#define VSFUSBD_CFG_SG_BUFFER_SIZE		64
+#endif
+
 #define VSFUSBD_EVT_DATAIO_INEP(ep)		(VSFUSBD_EVT_DATAIO_IN + (ep))
 #define VSFUSBD_EVT_DATAIO_OUTEP(ep)	(VSFUSBD_EVT_DATAIO_OUT + (ep))
 
@@ -84,6 +91,10 @@ struct vsfusbd_transact_callback_t
 struct vsfusbd_transact_t
 {
 	struct vsf_transaction_buffer_t tbuffer;
+	// if buflist is not NULL, data is transferred from/to the chain instead
+	// 		of tbuffer.buffer, and tbuffer.buffer.size is set to the size of
+	// 		the chain when the transaction starts
+	struct vsf_buffer_list_t *buflist;
 	struct vsfusbd_transact_callback_t callback;
 	
 	// private
@@ -0,0 +1,32 @@
+/***************************************************************************
+ *   Copyright (C) 2009 - 2010 by Simon Qian <SimonQian@SimonQian.com>     *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+// compiler config of host checks, GCC on the build machine
+// checks run in one thread except the lock-free paths under test,
+// 		so critical sections are empty
+
+#ifndef __HOST_COMPILER_H_INCLUDED__
+#define __HOST_COMPILER_H_INCLUDED__
+
+#include "../compiler/GCC/compiler.h"
+
+#define vsf_enter_critical()
+#define vsf_leave_critical()
+
+#endif	// __HOST_COMPILER_H_INCLUDED__
@@ -0,0 +1,217 @@
+/***************************************************************************
+ *   Copyright (C) 2009 - 2010 by Simon Qian <SimonQian@SimonQian.com>     *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+// check of the table driven CRC engine
+// every model, calculated bit by bit and with tables of slice 1, 4 and 8,
+// 		MUST match the check value and an independent bitwise reference,
+// 		on random buffers at random alignment and in random pieces
+// throughput of CRC-32 is printed for each way of calculation
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "app_cfg.h"
+#include "app_type.h"
+#include "tool/crc/crc.h"
+
+#define MODEL_NUM						7
+#define SLICE_NUM						4
+#define RANDOM_ROUNDS					3000
+#define RANDOM_SIZE						4096
+#define BENCH_SIZE						(1024 * 1024)
+#define BENCH_ROUNDS					16
+
+static const uint8_t crc_check_data[] = "123456789";
+static const uint32_t crc_check_value[MODEL_NUM] =
+{
+	0x75, 0xF4, 0x31C3, 0x29B1, 0x4B37, 0xCBF43926, 0x0376E6E7,
+};
+// slice 0 is bit by bit
+static const uint8_t crc_slice[SLICE_NUM] = {0, 1, 4, 8};
+static uint32_t crc_table[SLICE_NUM][MODEL_NUM][CRC_TABLE_SIZE(8)];
+static struct crc_model_t model[SLICE_NUM][MODEL_NUM];
+
+static uint32_t crc_reflect(uint32_t value, uint8_t width)
+{
+	uint32_t result = 0;
+	uint8_t i;
+	
+	for (i = 0; i < width; i++, value >>= 1)
+	{
+		result = (result << 1) | (value & 1);
+	}
+	return result;
+}
+
+// straight from the Rocksoft model, MSB first register of width bits
+static uint32_t crc_reference(struct crc_model_t *m, uint8_t *buff,
+								uint32_t size)
+{
+	uint32_t topbit = 1UL << (m->width - 1);
+	uint32_t mask = (topbit << 1) - 1;
+	uint32_t reg = m->init, i;
+	uint8_t data, bit;
+	
+	for (i = 0; i < size; i++)
+	{
+		data = m->refin ? crc_reflect(buff[i], 8) : buff[i];
+		for (bit = 0; bit < 8; bit++)
+		{
+			bool xor = ((reg & topbit) != 0) ^ ((data & 0x80) != 0);
+			
+			reg = (reg << 1) & mask;
+			if (xor)
+			{
+				reg ^= m->poly;
+			}
+			data <<= 1;
+		}
+	}
+	if (m->refout)
+	{
+		reg = crc_reflect(reg, m->width);
+	}
+	return (reg ^ m->xorout) & mask;
+}
+
+static void crc_init_models(void)
+{
+	struct crc_model_t m[MODEL_NUM] =
+	{
+		CRC_MODEL_CRC7_MMC(NULL, 1),
+		CRC_MODEL_CRC8(NULL, 1),
+		CRC_MODEL_CRC16_XMODEM(NULL, 1),
+		CRC_MODEL_CRC16_CCITT_FALSE(NULL, 1),
+		CRC_MODEL_CRC16_MODBUS(NULL, 1),
+		CRC_MODEL_CRC32(NULL, 1),
+		CRC_MODEL_CRC32_MPEG2(NULL, 1),
+	};
+	uint8_t s, i;
+	
+	for (s = 0; s < SLICE_NUM; s++)
+	{
+		for (i = 0; i < MODEL_NUM; i++)
+		{
+			model[s][i] = m[i];
+			if (crc_slice[s])
+			{
+				model[s][i].table = crc_table[s][i];
+				model[s][i].slice = crc_slice[s];
+			}
+		}
+	}
+}
+
+static uint32_t crc_check_random(void)
+{
+	static uint8_t buff[RANDOM_SIZE + 8];
+	uint32_t round, size, offset, pos, piece, i, ref, err = 0;
+	struct crc_t crc;
+	uint8_t s;
+	
+	for (round = 0; round < RANDOM_ROUNDS; round++)
+	{
+		size = rand() % RANDOM_SIZE;
+		offset = rand() % 8;
+		for (i = 0; i < size; i++)
+		{
+			buff[offset + i] = rand();
+		}
+		
+		for (i = 0; i < MODEL_NUM; i++)
+		{
+			ref = crc_reference(&model[0][i], &buff[offset], size);
+			for (s = 0; s < SLICE_NUM; s++)
+			{
+				crc_init(&crc, &model[s][i]);
+				for (pos = 0; pos < size; pos += piece)
+				{
+					piece = 1 + rand() % (size - pos);
+					crc_update(&crc, &buff[offset + pos], piece);
+				}
+				if (crc_final(&crc) != ref)
+				{
+					err++;
+				}
+			}
+		}
+	}
+	return err;
+}
+
+int main(void)
+{
+	static uint8_t buff[BENCH_SIZE];
+	uint32_t i, round, err = 0, result;
+	double mbps;
+	clock_t start;
+	uint8_t s;
+	
+	srand(1);
+	crc_init_models();
+	for (s = 0; s < SLICE_NUM; s++)
+	{
+		for (i = 0; i < MODEL_NUM; i++)
+		{
+			if ((crc_calc(&model[s][i], (uint8_t *)crc_check_data, 9) !=
+					crc_check_value[i]) ||
+				(crc_reference(&model[s][i], (uint8_t *)crc_check_data, 9) !=
+					crc_check_value[i]))
+			{
+				err++;
+			}
+		}
+	}
+	printf("crc_slice: %u check values wrong\n", err);
+	
+	i = crc_check_random();
+	printf("crc_slice: %u rounds, %u mismatches with bitwise reference\n",
+			RANDOM_ROUNDS, i);
+	err += i;
+	
+	for (i = 0; i < BENCH_SIZE; i++)
+	{
+		buff[i] = rand();
+	}
+	for (s = 0; s < SLICE_NUM; s++)
+	{
+		// bit by bit is slow, fewer rounds for it
+		uint32_t rounds = crc_slice[s] ? BENCH_ROUNDS : 1;
+		
+		start = clock();
+		for (round = 0; round < rounds; round++)
+		{
+			result = crc_calc(&model[s][5], buff, BENCH_SIZE);
+		}
+		mbps = (double)rounds * BENCH_SIZE / (1024 * 1024) /
+				((double)(clock() - start) / CLOCKS_PER_SEC);
+		if (crc_slice[s])
+		{
+			printf("crc_slice: CRC-32 slice %u: %.1f MB/s (0x%08X)\n",
+					crc_slice[s], mbps, result);
+		}
+		else
+		{
+			printf("crc_slice: CRC-32 bitwise: %.1f MB/s (0x%08X)\n",
+					mbps, result);
+		}
+	}
+	return err ? 1 : 0;
+}
@@ -0,0 +1,136 @@
+/***************************************************************************
+ *   Copyright (C) 2009 - 2010 by Simon Qian <SimonQian@SimonQian.com>     *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+// test of vsf_ring with one producer thread and one consumer thread
+// both sides mix byte, block and zero-copy access, data MUST arrive in order
+// 		and the ring MUST never report more data than its size
+
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "app_cfg.h"
+#include "app_type.h"
+#include "tool/buffer/buffer.h"
+
+#define RING_SIZE						64
+#define DATA_NUM						2000000
+
+static uint8_t ring_buffer[RING_SIZE];
+static struct vsf_ring_t ring = {{ring_buffer, sizeof(ring_buffer)}};
+
+static void* ring_producer(void *param)
+{
+	uint8_t data[37], *wbuf;
+	uint32_t i = 0, k, size = 0;
+	
+	while (i < DATA_NUM)
+	{
+		// ring full, let the consumer run if there is only one cpu
+		if (!size)
+		{
+			sched_yield();
+		}
+		switch (i % 3)
+		{
+		case 0:
+			size = vsf_ring_push8(&ring, (uint8_t)i);
+			break;
+		case 1:
+			// push is all or nothing
+			size = min(1 + i % sizeof(data), DATA_NUM - i);
+			for (k = 0; k < size; k++)
+			{
+				data[k] = (uint8_t)(i + k);
+			}
+			size = vsf_ring_push(&ring, size, data);
+			break;
+		default:
+			size = min(vsf_ring_get_wbuf(&ring, &wbuf), DATA_NUM - i);
+			size = min(size, 5);
+			for (k = 0; k < size; k++)
+			{
+				wbuf[k] = (uint8_t)(i + k);
+			}
+			size = vsf_ring_commit_write(&ring, size);
+			break;
+		}
+		i += size;
+	}
+	return NULL;
+}
+
+int main(void)
+{
+	struct vsf_ring_t ring_bad = {{ring_buffer, RING_SIZE - 1}};
+	uint8_t data[50], *rbuf;
+	uint32_t i = 0, k, size = 0, err = 0;
+	pthread_t thread;
+	
+	if (!vsf_ring_init(&ring_bad) || vsf_ring_init(&ring))
+	{
+		printf("vsf_ring_spsc: size which is not power of 2 is accepted\n");
+		return 1;
+	}
+	pthread_create(&thread, NULL, ring_producer, NULL);
+	
+	while (i < DATA_NUM)
+	{
+		// ring empty, let the producer run if there is only one cpu
+		if (!size)
+		{
+			sched_yield();
+		}
+		if (vsf_ring_get_data_length(&ring) > RING_SIZE)
+		{
+			err++;
+		}
+		
+		switch (i % 4)
+		{
+		case 0:
+			size = vsf_ring_pop8(&ring, data);
+			break;
+		case 1:
+			size = vsf_ring_pop(&ring, 1 + i % sizeof(data), data);
+			break;
+		default:
+			size = min(vsf_ring_get_rbuf(&ring, &rbuf), 7);
+			for (k = 0; k < size; k++)
+			{
+				data[k] = rbuf[k];
+			}
+			size = vsf_ring_commit_read(&ring, size);
+			break;
+		}
+		for (k = 0; k < size; k++)
+		{
+			if (data[k] != (uint8_t)(i + k))
+			{
+				err++;
+			}
+		}
+		i += size;
+	}
+	pthread_join(thread, NULL);
+	
+	printf("vsf_ring_spsc: %u bytes through %u bytes ring, %u errors\n",
+			i, RING_SIZE, err);
+	return err ? 1 : 0;
+}
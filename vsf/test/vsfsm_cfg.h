@@ -0,0 +1,33 @@
+/***************************************************************************
+ *   Copyright (C) 2009 - 2010 by Simon Qian <SimonQian@SimonQian.com>     *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#define VSFSM_CFG_EVTQ_SIZE				16
+#define VSFSM_CFG_PRIORITY_EN			1
+#define VSFSM_CFG_EVTQ_LOCKFREE_EN		1
+#define VSFSM_CFG_MAILBOX_EN			0
+#define VSFSM_CFG_PROFILE_EN			0
+#define VSFSM_CFG_SYNC_EN				1
+#define VSFSM_CFG_SYNC_TIMEOUT_EN		0
+#define VSFSM_CFG_ACTIVE_EN				0
+#define VSFSM_CFG_SM_EN					0
+#define VSFSM_CFG_SUBSM_EN				0
+#define VSFSM_CFG_HSM_EN				0
+#define VSFSM_CFG_PT_EN					0
+#define VSFSM_CFG_PT_STACK_EN			0
+#define VSFSM_CFG_THREAD_EN				0
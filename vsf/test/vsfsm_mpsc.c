@@ -0,0 +1,123 @@
+/***************************************************************************
+ *   Copyright (C) 2009 - 2010 by Simon Qian <SimonQian@SimonQian.com>     *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+// stress test of the lock-free MPSC event queue of vsfsm
+// producer threads post events to their own sm with vsfsm_post_evt_pending,
+// 		while the main thread polls, every event MUST be dispatched once and
+// 		in the order posted by its producer
+
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "app_cfg.h"
+#include "framework/vsfsm/vsfsm.h"
+
+#if !VSFSM_CFG_EVTQ_LOCKFREE_EN
+#error "VSFSM_CFG_EVTQ_LOCKFREE_EN MUST be enabled"
+#endif
+
+#define PRODUCER_NUM					4
+#define EVT_NUM							200000
+#define EVT_SEQ_MASK					0xFFF
+
+static struct vsfsm_t sm[PRODUCER_NUM];
+static volatile uint32_t evt_count[PRODUCER_NUM];
+static uint32_t evt_last[PRODUCER_NUM];
+static uint32_t evt_err;
+
+static struct vsfsm_state_t *
+mpsc_evt_handler(struct vsfsm_t *sm_cur, vsfsm_evt_t evt)
+{
+	uint32_t idx = sm_cur - sm, seq;
+	
+	if ((evt >= VSFSM_EVT_USER) && (evt <= VSFSM_EVT_USER + EVT_SEQ_MASK))
+	{
+		seq = evt - VSFSM_EVT_USER;
+		if (seq != ((evt_last[idx] + 1) & EVT_SEQ_MASK))
+		{
+			evt_err++;
+		}
+		evt_last[idx] = seq;
+		evt_count[idx]++;
+	}
+	return NULL;
+}
+
+static void* mpsc_producer(void *param)
+{
+	struct vsfsm_t *sm_cur = (struct vsfsm_t *)param;
+	uint32_t i;
+	
+	for (i = 1; i <= EVT_NUM; i++)
+	{
+		// queue full, wait for the consumer
+		while (vsfsm_post_evt_pending(sm_cur,
+								VSFSM_EVT_USER + (i & EVT_SEQ_MASK)))
+		{
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+int main(void)
+{
+	pthread_t thread[PRODUCER_NUM];
+	uint32_t i, total;
+	
+	for (i = 0; i < PRODUCER_NUM; i++)
+	{
+		sm[i].init_state.evt_handler = mpsc_evt_handler;
+#if VSFSM_CFG_PRIORITY_EN
+		sm[i].priority = i % 3;
+#endif
+		vsfsm_init(&sm[i]);
+	}
+	for (i = 0; i < PRODUCER_NUM; i++)
+	{
+		pthread_create(&thread[i], NULL, mpsc_producer, &sm[i]);
+	}
+	
+	do
+	{
+		// queue empty, let the producers run if there is only one cpu
+		if (!vsfsm_get_event_pending())
+		{
+			sched_yield();
+		}
+		vsfsm_poll();
+		for (total = 0, i = 0; i < PRODUCER_NUM; i++)
+		{
+			total += evt_count[i];
+		}
+	} while (total < PRODUCER_NUM * EVT_NUM);
+	
+	for (i = 0; i < PRODUCER_NUM; i++)
+	{
+		pthread_join(thread[i], NULL);
+	}
+	vsfsm_poll();
+	
+	printf("vsfsm_mpsc: %u events from %u producers, %u out of order, "
+			"%u pending\n", total, PRODUCER_NUM, evt_err,
+			vsfsm_get_event_pending());
+	return (evt_err || (total != PRODUCER_NUM * EVT_NUM) ||
+			vsfsm_get_event_pending()) ? 1 : 0;
+}
@@ -0,0 +1,221 @@
+/***************************************************************************
+ *   Copyright (C) 2009 - 2010 by Simon Qian <SimonQian@SimonQian.com>     *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+// check of the timing wheel of vsftimer
+// correctness: random register/unregister and tick jumps across the wrap of
+// 		the tick counter, every timer MUST expire exactly when it is due
+// timing: periodic timers processed every tick by the wheel, compared with
+// 		the unsorted timer list scanned every tick, which vsftimer used
+// 		before the wheel
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "app_cfg.h"
+#include "interfaces.h"
+#include "framework/vsftimer/vsftimer.h"
+
+#define TIMER_NUM						1000
+#define RANDOM_STEPS					20000
+#define BENCH_TICKS						20000
+
+static uint32_t tickcnt;
+static uint32_t wheel_get_count(void)
+{
+	return tickcnt;
+}
+const struct interfaces_info_t core_interfaces =
+{
+	.tickclk = {.get_count = wheel_get_count},
+};
+
+static struct vsftimer_timer_t timer[TIMER_NUM];
+static uint32_t deadline[TIMER_NUM];
+static bool registered[TIMER_NUM];
+static uint32_t expired[TIMER_NUM];
+static struct vsfsm_t sm;
+
+// instant events are dispatched in the processing of the wheel,
+// 		so the event queue will not overflow
+static struct vsfsm_state_t *
+wheel_evt_handler(struct vsfsm_t *sm_cur, vsfsm_evt_t evt)
+{
+	if ((evt >= VSFSM_EVT_USER_INSTANT) &&
+		(evt < VSFSM_EVT_USER_INSTANT + TIMER_NUM))
+	{
+		expired[evt - VSFSM_EVT_USER_INSTANT]++;
+	}
+	return NULL;
+}
+
+static void wheel_tick(uint32_t ticks)
+{
+	tickcnt += ticks;
+	vsftimer_callback_int();
+	while (vsfsm_get_event_pending())
+	{
+		vsfsm_poll();
+	}
+}
+
+static uint32_t wheel_check_random(void)
+{
+	uint32_t i, step, err = 0;
+	
+	for (step = 0; step < RANDOM_STEPS; step++)
+	{
+		i = rand() % TIMER_NUM;
+		if (rand() % 4)
+		{
+			// mostly short timers, some spanning higher levels of the wheel
+			timer[i].interval = (rand() % 3) ? rand() % 300 : rand() % 100000;
+			vsftimer_register(&timer[i]);
+			// current tick is already processed, so a timer with 0 interval
+			// 		expires in the next tick
+			deadline[i] = tickcnt + max(timer[i].interval, 1);
+			registered[i] = true;
+		}
+		else
+		{
+			vsftimer_unregister(&timer[i]);
+			registered[i] = false;
+		}
+		
+		wheel_tick((rand() % 4) ? rand() % 20 : rand() % 5000);
+		for (i = 0; i < TIMER_NUM; i++)
+		{
+			bool due = registered[i] && ((int32_t)(tickcnt - deadline[i]) >= 0);
+			
+			if (expired[i] != due)
+			{
+				err++;
+			}
+			if (expired[i])
+			{
+				// periodic timer is re-scheduled from the processing
+				deadline[i] = tickcnt + max(timer[i].interval, 1);
+			}
+			expired[i] = 0;
+		}
+	}
+	for (i = 0; i < TIMER_NUM; i++)
+	{
+		vsftimer_unregister(&timer[i]);
+	}
+	return err;
+}
+
+// timer list of vsftimer before the wheel, every timer is checked every tick
+struct list_timer_t
+{
+	uint32_t interval;
+	uint32_t start_tickcnt;
+	uint32_t evt;
+	struct list_timer_t *next;
+};
+static struct list_timer_t list_timer[TIMER_NUM];
+static struct list_timer_t *list_head;
+
+static void list_tick(void)
+{
+	struct list_timer_t *ptimer;
+	
+	tickcnt++;
+	for (ptimer = list_head; ptimer != NULL; ptimer = ptimer->next)
+	{
+		if ((tickcnt - ptimer->start_tickcnt) >= ptimer->interval)
+		{
+			ptimer->start_tickcnt = tickcnt;
+			vsfsm_post_evt(&sm, ptimer->evt);
+		}
+	}
+}
+
+static double bench_elapsed_ns(clock_t start)
+{
+	return (double)(clock() - start) * 1000000000 / CLOCKS_PER_SEC;
+}
+
+int main(void)
+{
+	uint32_t i, err, wheel_expired = 0, list_expired = 0;
+	double wheel_ns, list_ns;
+	clock_t start;
+	
+	srand(1);
+	// start near the wrap of the tick counter
+	tickcnt = 0xFFFF0000;
+	vsftimer_init();
+	sm.init_state.evt_handler = wheel_evt_handler;
+	vsfsm_init(&sm);
+	for (i = 0; i < TIMER_NUM; i++)
+	{
+		timer[i].sm = &sm;
+		timer[i].evt = VSFSM_EVT_USER_INSTANT + i;
+		timer[i].mode = VSFTIMER_MODE_PERIODIC;
+	}
+	err = wheel_check_random();
+	printf("vsftimer_wheel: %u random steps, %u errors\n", RANDOM_STEPS, err);
+	
+	// same periodic timers in the wheel and in the list
+	for (i = 0; i < TIMER_NUM; i++)
+	{
+		timer[i].interval = 1 + rand() % 1000;
+		timer[i].slack = 0;
+		expired[i] = 0;
+		vsftimer_register(&timer[i]);
+		
+		list_timer[i].interval = timer[i].interval;
+		list_timer[i].start_tickcnt = tickcnt;
+		list_timer[i].evt = timer[i].evt;
+		list_timer[i].next = list_head;
+		list_head = &list_timer[i];
+	}
+	
+	start = clock();
+	for (i = 0; i < BENCH_TICKS; i++)
+	{
+		wheel_tick(1);
+	}
+	wheel_ns = bench_elapsed_ns(start) / BENCH_TICKS;
+	for (i = 0; i < TIMER_NUM; i++)
+	{
+		vsftimer_unregister(&timer[i]);
+		wheel_expired += expired[i];
+		expired[i] = 0;
+	}
+	
+	tickcnt -= BENCH_TICKS;
+	start = clock();
+	for (i = 0; i < BENCH_TICKS; i++)
+	{
+		list_tick();
+	}
+	list_ns = bench_elapsed_ns(start) / BENCH_TICKS;
+	for (i = 0; i < TIMER_NUM; i++)
+	{
+		list_expired += expired[i];
+	}
+	
+	printf("vsftimer_wheel: %u timers, %u ticks, wheel %.0f ns/tick, "
+			"list %.0f ns/tick, %u/%u expired\n", TIMER_NUM, BENCH_TICKS,
+			wheel_ns, list_ns, wheel_expired, list_expired);
+	return (err || (wheel_expired != list_expired)) ? 1 : 0;
+}
@@ -17,11 +17,83 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+#include "app_cfg.h"
 #include "app_type.h"
 #include "compiler.h"
 
 #include "buffer.h"
 
+// buffer_list
+uint32_t vsf_buffer_list_get_size(struct vsf_buffer_list_t *list)
+{
+	uint32_t size = 0;
+	
+	for (; list != NULL; list = list->next)
+	{
+		size += list->buffer.size;
+	}
+	return size;
+}
+
+// find the segment containing offset, and convert offset into the segment
+static struct vsf_buffer_list_t* vsf_buffer_list_seek(
+						struct vsf_buffer_list_t *list, uint32_t *offset)
+{
+	while ((list != NULL) && (*offset >= list->buffer.size))
+	{
+		*offset -= list->buffer.size;
+		list = list->next;
+	}
+	return list;
+}
+
+uint8_t* vsf_buffer_list_get_ptr(struct vsf_buffer_list_t *list,
+									uint32_t offset, uint32_t size)
+{
+	list = vsf_buffer_list_seek(list, &offset);
+	if ((NULL == list) || (size > (list->buffer.size - offset)))
+	{
+		return NULL;
+	}
+	return &list->buffer.buffer[offset];
+}
+
+static uint32_t vsf_buffer_list_copy(struct vsf_buffer_list_t *list,
+				uint32_t offset, uint32_t size, uint8_t *data, bool write)
+{
+	uint32_t cur_size, copied = 0;
+	
+	list = vsf_buffer_list_seek(list, &offset);
+	while ((list != NULL) && (copied < size))
+	{
+		cur_size = min(size - copied, list->buffer.size - offset);
+		if (write)
+		{
+			memcpy(&list->buffer.buffer[offset], &data[copied], cur_size);
+		}
+		else
+		{
+			memcpy(&data[copied], &list->buffer.buffer[offset], cur_size);
+		}
+		copied += cur_size;
+		offset = 0;
+		list = list->next;
+	}
+	return copied;
+}
+
+uint32_t vsf_buffer_list_read(struct vsf_buffer_list_t *list,
+						uint32_t offset, uint32_t size, uint8_t *data)
+{
+	return vsf_buffer_list_copy(list, offset, size, data, false);
+}
+
+uint32_t vsf_buffer_list_write(struct vsf_buffer_list_t *list,
+						uint32_t offset, uint32_t size, uint8_t *data)
+{
+	return vsf_buffer_list_copy(list, offset, size, data, true);
+}
+
 //#define vsf_fifo_get_next_index(pos, size)	(((pos) + 1) % (size))
 static uint32_t vsf_fifo_get_next_index(uint32_t pos, uint32_t size)
 {
@@ -226,6 +298,192 @@ uint32_t vsf_fifo_pop(struct vsf_fifo_t *fifo, uint32_t size, uint8_t *data)
 	return ret;
 }
 
+// ring
+#define vsf_ring_offset(ring, pos)	((pos) & ((ring)->buffer.size - 1))
+
+vsf_err_t vsf_ring_init(struct vsf_ring_t *ring)
+{
+#if __VSF_DEBUG__
+	if (NULL == ring)
+	{
+		return VSFERR_INVALID_PARAMETER;
+	}
+#endif
+	if (!ring->buffer.size || (ring->buffer.size & (ring->buffer.size - 1)))
+	{
+		return VSFERR_INVALID_PARAMETER;
+	}
+	
+	ring->head = ring->tail = 0;
+	return VSFERR_NONE;
+}
+
+uint32_t vsf_ring_get_data_length(struct vsf_ring_t *ring)
+{
+	return ring->head - ring->tail;
+}
+
+uint32_t vsf_ring_get_avail_length(struct vsf_ring_t *ring)
+{
+	return ring->buffer.size - (ring->head - ring->tail);
+}
+
+uint32_t vsf_ring_push8(struct vsf_ring_t *ring, uint8_t data)
+{
+	uint32_t head = ring->head;
+	
+	if ((head - ring->tail) >= ring->buffer.size)
+	{
+		return 0;
+	}
+	
+	ring->buffer.buffer[vsf_ring_offset(ring, head)] = data;
+	// data MUST be written before head is published to the consumer
+	vsf_barrier();
+	ring->head = head + 1;
+	return 1;
+}
+
+uint32_t vsf_ring_pop8(struct vsf_ring_t *ring, uint8_t *data)
+{
+	uint32_t tail = ring->tail;
+	
+	if (ring->head == tail)
+	{
+		return 0;
+	}
+	
+	// data MUST be read after head, and before tail is published
+	vsf_barrier();
+	*data = ring->buffer.buffer[vsf_ring_offset(ring, tail)];
+	vsf_barrier();
+	ring->tail = tail + 1;
+	return 1;
+}
+
+uint32_t vsf_ring_push(struct vsf_ring_t *ring, uint32_t size, uint8_t *data)
+{
+	uint32_t head = ring->head;
+	uint32_t offset = vsf_ring_offset(ring, head);
+	uint32_t tmp32 = ring->buffer.size - offset;
+	
+#if __VSF_DEBUG__
+	if ((NULL == ring) || (NULL == data))
+	{
+		return 0;
+	}
+#endif
+	if (size > (ring->buffer.size - (head - ring->tail)))
+	{
+		return 0;
+	}
+	
+	if (size > tmp32)
+	{
+		memcpy(&ring->buffer.buffer[offset], &data[0], tmp32);
+		memcpy(&ring->buffer.buffer[0], &data[tmp32], size - tmp32);
+	}
+	else
+	{
+		memcpy(&ring->buffer.buffer[offset], data, size);
+	}
+	vsf_barrier();
+	ring->head = head + size;
+	return size;
+}
+
+uint32_t vsf_ring_peek(struct vsf_ring_t *ring, uint32_t size, uint8_t *data)
+{
+	uint32_t tail = ring->tail;
+	uint32_t offset = vsf_ring_offset(ring, tail);
+	uint32_t tmp32 = ring->buffer.size - offset;
+	uint32_t data_len = ring->head - tail;
+	
+#if __VSF_DEBUG__
+	if ((NULL == ring) || (NULL == data))
+	{
+		return 0;
+	}
+#endif
+	if (size > data_len)
+	{
+		size = data_len;
+	}
+	
+	vsf_barrier();
+	if (size > tmp32)
+	{
+		memcpy(&data[0], &ring->buffer.buffer[offset], tmp32);
+		memcpy(&data[tmp32], &ring->buffer.buffer[0], size - tmp32);
+	}
+	else
+	{
+		memcpy(data, &ring->buffer.buffer[offset], size);
+	}
+	return size;
+}
+
+uint32_t vsf_ring_pop(struct vsf_ring_t *ring, uint32_t size, uint8_t *data)
+{
+	uint32_t ret = vsf_ring_peek(ring, size, data);
+	
+	if (ret)
+	{
+		vsf_barrier();
+		ring->tail += ret;
+	}
+	return ret;
+}
+
+uint32_t vsf_ring_get_wbuf(struct vsf_ring_t *ring, uint8_t **data)
+{
+	uint32_t head = ring->head;
+	uint32_t offset = vsf_ring_offset(ring, head);
+	uint32_t avail_len = ring->buffer.size - (head - ring->tail);
+	
+	*data = &ring->buffer.buffer[offset];
+	return min(avail_len, ring->buffer.size - offset);
+}
+
+uint32_t vsf_ring_commit_write(struct vsf_ring_t *ring, uint32_t size)
+{
+	uint8_t *data;
+	uint32_t wbuf_len = vsf_ring_get_wbuf(ring, &data);
+	
+	if (size > wbuf_len)
+	{
+		size = wbuf_len;
+	}
+	vsf_barrier();
+	ring->head += size;
+	return size;
+}
+
+uint32_t vsf_ring_get_rbuf(struct vsf_ring_t *ring, uint8_t **data)
+{
+	uint32_t tail = ring->tail;
+	uint32_t offset = vsf_ring_offset(ring, tail);
+	uint32_t data_len = ring->head - tail;
+	
+	vsf_barrier();
+	*data = &ring->buffer.buffer[offset];
+	return min(data_len, ring->buffer.size - offset);
+}
+
+uint32_t vsf_ring_commit_read(struct vsf_ring_t *ring, uint32_t size)
+{
+	uint8_t *data;
+	uint32_t rbuf_len = vsf_ring_get_rbuf(ring, &data);
+	
+	if (size > rbuf_len)
+	{
+		size = rbuf_len;
+	}
+	vsf_barrier();
+	ring->tail += size;
+	return size;
+}
+
 // multibuf
 vsf_err_t vsf_multibuf_init(struct vsf_multibuf_t *mbuffer)
 {
@@ -308,15 +566,318 @@ vsf_err_t vsf_multibuf_pop(struct vsf_multibuf_t *mbuffer)
 	return VSFERR_NONE;
 }
 
+// pktfifo
+// data is in [tail, head) if not wrapped,
+// 		else in [tail, wrap) and [0, head) with head <= tail
+#define VSF_PKTFIFO_HEAD_SIZE			2
+#define VSF_PKTFIFO_MAX_PACKET_SIZE		0xFFFF
+
+static void vsf_pktfifo_reset(struct vsf_pktfifo_t *pktfifo)
+{
+	pktfifo->head = pktfifo->tail = 0;
+	pktfifo->wrap = pktfifo->buffer.size;
+}
+
+static bool vsf_pktfifo_wrapped(struct vsf_pktfifo_t *pktfifo)
+{
+	return (pktfifo->head < pktfifo->tail) ||
+		((pktfifo->head == pktfifo->tail) && (pktfifo->packet_num > 0));
+}
+
+// get contiguous room at head
+static uint32_t vsf_pktfifo_get_room(struct vsf_pktfifo_t *pktfifo)
+{
+	return vsf_pktfifo_wrapped(pktfifo) ? pktfifo->tail - pktfifo->head :
+				pktfifo->buffer.size - pktfifo->head;
+}
+
+vsf_err_t vsf_pktfifo_init(struct vsf_pktfifo_t *pktfifo)
+{
+#if __VSF_DEBUG__
+	if (NULL == pktfifo)
+	{
+		return VSFERR_INVALID_PARAMETER;
+	}
+#endif
+	
+	pktfifo->packet_num = 0;
+	pktfifo->dropped = 0;
+	vsf_pktfifo_reset(pktfifo);
+	return VSFERR_NONE;
+}
+
+uint8_t* vsf_pktfifo_get_rbuf(struct vsf_pktfifo_t *pktfifo, uint32_t *size)
+{
+	uint8_t *ptr;
+	
+#if __VSF_DEBUG__
+	if ((NULL == pktfifo) || (NULL == size))
+	{
+		return NULL;
+	}
+#endif
+	if (!pktfifo->packet_num)
+	{
+		return NULL;
+	}
+	
+	ptr = &pktfifo->buffer.buffer[pktfifo->tail];
+	*size = GET_LE_U16(ptr);
+	return ptr + VSF_PKTFIFO_HEAD_SIZE;
+}
+
+vsf_err_t vsf_pktfifo_commit_read(struct vsf_pktfifo_t *pktfifo)
+{
+	uint8_t *ptr;
+	
+#if __VSF_DEBUG__
+	if (NULL == pktfifo)
+	{
+		return VSFERR_INVALID_PARAMETER;
+	}
+#endif
+	if (!pktfifo->packet_num)
+	{
+		return VSFERR_FAIL;
+	}
+	
+	ptr = &pktfifo->buffer.buffer[pktfifo->tail];
+	pktfifo->tail += VSF_PKTFIFO_HEAD_SIZE + GET_LE_U16(ptr);
+	if (!--pktfifo->packet_num)
+	{
+		vsf_pktfifo_reset(pktfifo);
+	}
+	else if (pktfifo->tail >= pktfifo->wrap)
+	{
+		pktfifo->tail = 0;
+		pktfifo->wrap = pktfifo->buffer.size;
+	}
+	return VSFERR_NONE;
+}
+
+uint8_t* vsf_pktfifo_get_wbuf(struct vsf_pktfifo_t *pktfifo, uint32_t size)
+{
+	uint32_t need = VSF_PKTFIFO_HEAD_SIZE + size;
+	
+#if __VSF_DEBUG__
+	if (NULL == pktfifo)
+	{
+		return NULL;
+	}
+#endif
+	if ((size > VSF_PKTFIFO_MAX_PACKET_SIZE) || (need > pktfifo->buffer.size))
+	{
+		return NULL;
+	}
+	
+	while (1)
+	{
+		if (!pktfifo->packet_num)
+		{
+			vsf_pktfifo_reset(pktfifo);
+		}
+		
+		if (vsf_pktfifo_get_room(pktfifo) >= need)
+		{
+			break;
+		}
+		if (!vsf_pktfifo_wrapped(pktfifo) && (pktfifo->tail >= need))
+		{
+			// no room at the end, wrap to the start of the buffer
+			pktfifo->wrap = pktfifo->head;
+			pktfifo->head = 0;
+			break;
+		}
+		if (!pktfifo->drop_oldest)
+		{
+			return NULL;
+		}
+		vsf_pktfifo_commit_read(pktfifo);
+		pktfifo->dropped++;
+	}
+	return &pktfifo->buffer.buffer[pktfifo->head + VSF_PKTFIFO_HEAD_SIZE];
+}
+
+vsf_err_t vsf_pktfifo_commit_write(struct vsf_pktfifo_t *pktfifo,
+									uint32_t size)
+{
+	uint8_t *ptr;
+	
+#if __VSF_DEBUG__
+	if (NULL == pktfifo)
+	{
+		return VSFERR_INVALID_PARAMETER;
+	}
+#endif
+	if ((size > VSF_PKTFIFO_MAX_PACKET_SIZE) ||
+		(vsf_pktfifo_get_room(pktfifo) < (VSF_PKTFIFO_HEAD_SIZE + size)))
+	{
+		return VSFERR_FAIL;
+	}
+	
+	ptr = &pktfifo->buffer.buffer[pktfifo->head];
+	SET_LE_U16(ptr, size);
+	pktfifo->head += VSF_PKTFIFO_HEAD_SIZE + size;
+	pktfifo->packet_num++;
+	return VSFERR_NONE;
+}
+
+uint32_t vsf_pktfifo_push(struct vsf_pktfifo_t *pktfifo, uint32_t size,
+							uint8_t *data)
+{
+	uint8_t *ptr;
+	
+#if __VSF_DEBUG__
+	if (NULL == data)
+	{
+		return 0;
+	}
+#endif
+	
+	ptr = vsf_pktfifo_get_wbuf(pktfifo, size);
+	if (NULL == ptr)
+	{
+		return 0;
+	}
+	memcpy(ptr, data, size);
+	vsf_pktfifo_commit_write(pktfifo, size);
+	return size;
+}
+
+uint32_t vsf_pktfifo_pop(struct vsf_pktfifo_t *pktfifo, uint32_t size,
+							uint8_t *data)
+{
+	uint32_t packet_size;
+	uint8_t *ptr;
+	
+#if __VSF_DEBUG__
+	if (NULL == data)
+	{
+		return 0;
+	}
+#endif
+	
+	ptr = vsf_pktfifo_get_rbuf(pktfifo, &packet_size);
+	if ((NULL == ptr) || (packet_size > size))
+	{
+		return 0;
+	}
+	memcpy(data, ptr, packet_size);
+	vsf_pktfifo_commit_read(pktfifo);
+	return packet_size;
+}
+
+// rcbuf
+vsf_err_t vsf_rcbuf_pool_init(struct vsf_rcbuf_pool_t *pool)
+{
+	struct vsf_rcbuf_t *rcbuf;
+	uint8_t i;
+	
+#if __VSF_DEBUG__
+	if ((NULL == pool) || ((NULL == pool->rcbuf) && pool->num))
+	{
+		return VSFERR_INVALID_PARAMETER;
+	}
+#endif
+	
+	pool->free_list = NULL;
+	for (i = pool->num; i > 0; i--)
+	{
+		rcbuf = &pool->rcbuf[i - 1];
+		rcbuf->ref = 0;
+		rcbuf->pool = pool;
+		rcbuf->next = pool->free_list;
+		pool->free_list = rcbuf;
+	}
+	return VSFERR_NONE;
+}
+
+struct vsf_rcbuf_t* vsf_rcbuf_alloc(struct vsf_rcbuf_pool_t *pool)
+{
+	struct vsf_rcbuf_t *rcbuf = pool->free_list;
+	
+	if (rcbuf != NULL)
+	{
+		pool->free_list = rcbuf->next;
+		rcbuf->next = NULL;
+		rcbuf->ref = 1;
+	}
+	return rcbuf;
+}
+
+struct vsf_rcbuf_t* vsf_rcbuf_take(struct vsf_rcbuf_t *rcbuf)
+{
+	rcbuf->ref++;
+	return rcbuf;
+}
+
+void vsf_rcbuf_release(struct vsf_rcbuf_t *rcbuf)
+{
+	if ((rcbuf != NULL) && !--rcbuf->ref)
+	{
+		rcbuf->next = rcbuf->pool->free_list;
+		rcbuf->pool->free_list = rcbuf;
+	}
+}
+
 // bufmgr
-struct vsf_bufmgr_record_t
+// header of arena chunk, next is only valid in free chunk
+struct vsf_bufmgr_chunk_t
 {
 	uint32_t size;
-	uint8_t *ptr;
+	struct vsf_bufmgr_chunk_t *next;
 };
 
+#define VSF_BUFMGR_ALIGN(size)			\
+	(((size) + VSF_BUFMGR_CFG_ALIGN - 1) & ~(VSF_BUFMGR_CFG_ALIGN - 1))
+#define VSF_BUFMGR_CHUNK_HEAD_SIZE		\
+	VSF_BUFMGR_ALIGN(sizeof(struct vsf_bufmgr_chunk_t))
+#define VSF_BUFMGR_CHUNK_MIN_SIZE		\
+	(VSF_BUFMGR_CHUNK_HEAD_SIZE + VSF_BUFMGR_CFG_ALIGN)
+
+static uint8_t* vsf_bufmgr_align_buffer(struct vsf_buffer_t *buffer,
+										uint32_t *size)
+{
+	uint32_t addr = (uint32_t)buffer->buffer;
+	uint32_t pad = VSF_BUFMGR_ALIGN(addr) - addr;
+	
+	*size = (buffer->size > pad) ?
+				(buffer->size - pad) & ~(VSF_BUFMGR_CFG_ALIGN - 1) : 0;
+	return buffer->buffer + pad;
+}
+
+static void vsf_bufmgr_stat_inc(struct vsf_bufmgr_stat_t *stat, uint32_t size)
+{
+	stat->in_use += size;
+	if (stat->in_use > stat->peak)
+	{
+		stat->peak = stat->in_use;
+	}
+}
+
+static void vsf_bufmgr_pool_init(struct vsf_bufmgr_pool_t *pool)
+{
+	uint32_t size, i;
+	uint8_t *ptr = vsf_bufmgr_align_buffer(&pool->buffer, &size);
+	
+	pool->block_size = VSF_BUFMGR_ALIGN(max(pool->block_size, sizeof(void *)));
+	pool->block_num = size / pool->block_size;
+	pool->free_list = NULL;
+	for (i = pool->block_num; i > 0; i--)
+	{
+		void **block = (void **)(ptr + (i - 1) * pool->block_size);
+		*block = pool->free_list;
+		pool->free_list = block;
+	}
+	memset(&pool->stat, 0, sizeof(pool->stat));
+}
+
 void vsf_bufmgr_init(struct vsf_bufmgr_t *bufmgr)
 {
+	struct vsf_bufmgr_chunk_t *chunk;
+	uint32_t size;
+	uint8_t i;
+	
 #if __VSF_DEBUG__
 	if (NULL == bufmgr)
 	{
@@ -324,13 +885,105 @@ void vsf_bufmgr_init(struct vsf_bufmgr_t *bufmgr)
 	}
 #endif
 	
-	bufmgr->num_of_buffer = 0;
+	for (i = 0; i < bufmgr->pool_num; i++)
+	{
+		vsf_bufmgr_pool_init(&bufmgr->pool[i]);
+	}
+	
+	bufmgr->free_list = NULL;
+	memset(&bufmgr->stat, 0, sizeof(bufmgr->stat));
+	chunk = (struct vsf_bufmgr_chunk_t *)
+					vsf_bufmgr_align_buffer(&bufmgr->buffer, &size);
+	if ((bufmgr->buffer.buffer != NULL) && (size >= VSF_BUFMGR_CHUNK_MIN_SIZE))
+	{
+		chunk->size = size;
+		chunk->next = NULL;
+		bufmgr->free_list = chunk;
+	}
+}
+
+static void* vsf_bufmgr_arena_malloc(struct vsf_bufmgr_t *bufmgr,
+										uint32_t size)
+{
+	struct vsf_bufmgr_chunk_t **pnext = (struct vsf_bufmgr_chunk_t **)
+											&bufmgr->free_list;
+	struct vsf_bufmgr_chunk_t *chunk, *remain;
+	
+	if (size > bufmgr->buffer.size)
+	{
+		return NULL;
+	}
+	size = VSF_BUFMGR_CHUNK_HEAD_SIZE + VSF_BUFMGR_ALIGN(size);
+	
+	for (chunk = *pnext; chunk != NULL; pnext = &chunk->next, chunk = *pnext)
+	{
+		if (chunk->size >= size)
+		{
+			if ((chunk->size - size) >= VSF_BUFMGR_CHUNK_MIN_SIZE)
+			{
+				remain = (struct vsf_bufmgr_chunk_t *)((uint8_t *)chunk + size);
+				remain->size = chunk->size - size;
+				remain->next = chunk->next;
+				chunk->size = size;
+				*pnext = remain;
+			}
+			else
+			{
+				*pnext = chunk->next;
+			}
+			vsf_bufmgr_stat_inc(&bufmgr->stat, chunk->size);
+			return (uint8_t *)chunk + VSF_BUFMGR_CHUNK_HEAD_SIZE;
+		}
+	}
+	return NULL;
+}
+
+static void vsf_bufmgr_arena_free(struct vsf_bufmgr_t *bufmgr, void *ptr)
+{
+	struct vsf_bufmgr_chunk_t *chunk = (struct vsf_bufmgr_chunk_t *)
+							((uint8_t *)ptr - VSF_BUFMGR_CHUNK_HEAD_SIZE);
+	struct vsf_bufmgr_chunk_t *prev = NULL;
+	struct vsf_bufmgr_chunk_t *next = bufmgr->free_list;
+	
+	bufmgr->stat.in_use -= chunk->size;
+	
+	// free list is sorted by address, so adjacent chunks can be merged
+	while ((next != NULL) && (next < chunk))
+	{
+		prev = next;
+		next = next->next;
+	}
+	
+	if ((next != NULL) && (((uint8_t *)chunk + chunk->size) == (uint8_t *)next))
+	{
+		chunk->size += next->size;
+		chunk->next = next->next;
+	}
+	else
+	{
+		chunk->next = next;
+	}
+	
+	if (NULL == prev)
+	{
+		bufmgr->free_list = chunk;
+	}
+	else if (((uint8_t *)prev + prev->size) == (uint8_t *)chunk)
+	{
+		prev->size += chunk->size;
+		prev->next = chunk->next;
+	}
+	else
+	{
+		prev->next = chunk;
+	}
 }
 
 void* vsf_bufmgr_malloc(struct vsf_bufmgr_t *bufmgr, uint32_t size)
 {
-	REFERENCE_PARAMETER(bufmgr);
-	REFERENCE_PARAMETER(size);
+	struct vsf_bufmgr_pool_t *pool;
+	void *ptr;
+	uint8_t i;
 	
 #if __VSF_DEBUG__
 	if (NULL == bufmgr)
@@ -338,14 +991,42 @@ void* vsf_bufmgr_malloc(struct vsf_bufmgr_t *bufmgr, uint32_t size)
 		return NULL;
 	}
 #endif
+	if (!size)
+	{
+		return NULL;
+	}
 	
-	return NULL;
+	// try the smallest fitting pool first, then larger pools
+	for (i = 0; i < bufmgr->pool_num; i++)
+	{
+		pool = &bufmgr->pool[i];
+		if (pool->block_size < size)
+		{
+			continue;
+		}
+		
+		ptr = pool->free_list;
+		if (ptr != NULL)
+		{
+			pool->free_list = *(void **)ptr;
+			vsf_bufmgr_stat_inc(&pool->stat, 1);
+			return ptr;
+		}
+		pool->stat.failures++;
+	}
+	
+	ptr = vsf_bufmgr_arena_malloc(bufmgr, size);
+	if (NULL == ptr)
+	{
+		bufmgr->stat.failures++;
+	}
+	return ptr;
 }
 
 void vsf_bufmgr_free(struct vsf_bufmgr_t *bufmgr, void *ptr)
 {
-	REFERENCE_PARAMETER(bufmgr);
-	REFERENCE_PARAMETER(ptr);
+	struct vsf_bufmgr_pool_t *pool;
+	uint8_t i;
 	
 #if __VSF_DEBUG__
 	if (NULL == bufmgr)
@@ -353,6 +1034,22 @@ void vsf_bufmgr_free(struct vsf_bufmgr_t *bufmgr, void *ptr)
 		return;
 	}
 #endif
+	if (NULL == ptr)
+	{
+		return;
+	}
 	
-	
+	for (i = 0; i < bufmgr->pool_num; i++)
+	{
+		pool = &bufmgr->pool[i];
+		if (((uint8_t *)ptr >= pool->buffer.buffer) &&
+			((uint8_t *)ptr < (pool->buffer.buffer + pool->buffer.size)))
+		{
+			*(void **)ptr = pool->free_list;
+			pool->free_list = ptr;
+			pool->stat.in_use--;
+			return;
+		}
+	}
+	vsf_bufmgr_arena_free(bufmgr, ptr);
 }
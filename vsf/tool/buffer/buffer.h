@@ -32,6 +32,24 @@ struct vsf_transaction_buffer_t
 	uint32_t position;
 };
 
+// buffer_list
+// iovec-style chain of buffers, a layer can prepend or append segments to
+// 		the chain of another layer without copying data
+struct vsf_buffer_list_t
+{
+	struct vsf_buffer_t buffer;
+	struct vsf_buffer_list_t *next;
+};
+uint32_t vsf_buffer_list_get_size(struct vsf_buffer_list_t *list);
+// return NULL if [offset, offset + size) is not in one segment
+uint8_t* vsf_buffer_list_get_ptr(struct vsf_buffer_list_t *list,
+									uint32_t offset, uint32_t size);
+// gather from/scatter to the chain, return the size actually copied
+uint32_t vsf_buffer_list_read(struct vsf_buffer_list_t *list,
+						uint32_t offset, uint32_t size, uint8_t *data);
+uint32_t vsf_buffer_list_write(struct vsf_buffer_list_t *list,
+						uint32_t offset, uint32_t size, uint8_t *data);
+
 // fifo
 struct vsf_fifo_t
 {
@@ -50,6 +68,38 @@ uint32_t vsf_fifo_peek_consequent(struct vsf_fifo_t *fifo, uint32_t size,
 uint32_t vsf_fifo_get_data_length(struct vsf_fifo_t *fifo);
 uint32_t vsf_fifo_get_avail_length(struct vsf_fifo_t *fifo);
 
+// ring
+// single-producer single-consumer ring with power-of-two size
+// head is only written by the producer and tail is only written by the
+// 		consumer, both are free-running and wrapped by mask, so the ring is
+// 		safe for one producer and one consumer in different contexts
+// 		(eg. interrupt and main loop) without locking, and no slot is wasted
+struct vsf_ring_t
+{
+	struct vsf_buffer_t buffer;
+	volatile uint32_t head;
+	volatile uint32_t tail;
+};
+// return VSFERR_INVALID_PARAMETER if size of the buffer is not power of 2
+vsf_err_t vsf_ring_init(struct vsf_ring_t *ring);
+uint32_t vsf_ring_push8(struct vsf_ring_t *ring, uint8_t data);
+uint32_t vsf_ring_pop8(struct vsf_ring_t *ring, uint8_t *data);
+// push is all or nothing, pop and peek return the size available
+uint32_t vsf_ring_push(struct vsf_ring_t *ring, uint32_t size, uint8_t *data);
+uint32_t vsf_ring_pop(struct vsf_ring_t *ring, uint32_t size, uint8_t *data);
+uint32_t vsf_ring_peek(struct vsf_ring_t *ring, uint32_t size, uint8_t *data);
+uint32_t vsf_ring_get_data_length(struct vsf_ring_t *ring);
+uint32_t vsf_ring_get_avail_length(struct vsf_ring_t *ring);
+// zero-copy access
+// get_wbuf/get_rbuf return the size of the largest contiguous span to be
+// 		written/read, and the span is returned in data
+// commit_write/commit_read publish size bytes in the span, return the size
+// 		committed, which will not exceed the size of the span
+uint32_t vsf_ring_get_wbuf(struct vsf_ring_t *ring, uint8_t **data);
+uint32_t vsf_ring_commit_write(struct vsf_ring_t *ring, uint32_t size);
+uint32_t vsf_ring_get_rbuf(struct vsf_ring_t *ring, uint8_t **data);
+uint32_t vsf_ring_commit_read(struct vsf_ring_t *ring, uint32_t size);
+
 // multi_buffer
 struct vsf_multibuf_t
 {
@@ -68,11 +118,116 @@ vsf_err_t vsf_multibuf_push(struct vsf_multibuf_t *mbuffer);
 uint8_t* vsf_multibuf_get_payload(struct vsf_multibuf_t *mbuffer);
 vsf_err_t vsf_multibuf_pop(struct vsf_multibuf_t *mbuffer);
 
+// packet_fifo
+// variable-length packets are stored contiguously with a 16-bit length
+// 		prefix, a packet never wraps, so it can be accessed zero-copy
+// if drop_oldest is set, oldest packets are dropped to make room for new
+// 		packet, else write fails when there is not enough room
+// packet_fifo is NOT reentrant, protect it if used in interrupt
+struct vsf_pktfifo_t
+{
+	struct vsf_buffer_t buffer;
+	bool drop_oldest;
+	
+	// read only
+	uint32_t packet_num;
+	uint32_t dropped;
+	// private
+	uint32_t head;
+	uint32_t tail;
+	uint32_t wrap;
+};
+vsf_err_t vsf_pktfifo_init(struct vsf_pktfifo_t *pktfifo);
+uint32_t vsf_pktfifo_push(struct vsf_pktfifo_t *pktfifo, uint32_t size,
+							uint8_t *data);
+// return 0 if no packet or size is less than size of the packet
+uint32_t vsf_pktfifo_pop(struct vsf_pktfifo_t *pktfifo, uint32_t size,
+							uint8_t *data);
+// zero-copy access
+// get_wbuf reserves room for a packet up to size bytes, and return NULL if
+// 		not available, commit_write then publishes the packet with actual size
+uint8_t* vsf_pktfifo_get_wbuf(struct vsf_pktfifo_t *pktfifo, uint32_t size);
+vsf_err_t vsf_pktfifo_commit_write(struct vsf_pktfifo_t *pktfifo,
+									uint32_t size);
+// get_rbuf returns the oldest packet, commit_read then drops it
+uint8_t* vsf_pktfifo_get_rbuf(struct vsf_pktfifo_t *pktfifo, uint32_t *size);
+vsf_err_t vsf_pktfifo_commit_read(struct vsf_pktfifo_t *pktfifo);
+
+// rcbuf
+// reference-counted buffer allocated from a pool, every user of the buffer
+// 		takes a reference, and the buffer returns to the pool when the last
+// 		reference is released
+// rcbuf is NOT reentrant, protect it if used in interrupt
+struct vsf_rcbuf_pool_t;
+struct vsf_rcbuf_t
+{
+	struct vsf_buffer_t buffer;
+	// used by the pool when free, and can be used by the owner to queue
+	// 		the buffer when allocated
+	struct vsf_rcbuf_t *next;
+	
+	// private
+	uint8_t ref;
+	struct vsf_rcbuf_pool_t *pool;
+};
+struct vsf_rcbuf_pool_t
+{
+	struct vsf_rcbuf_t *rcbuf;
+	uint8_t num;
+	
+	// private
+	struct vsf_rcbuf_t *free_list;
+};
+vsf_err_t vsf_rcbuf_pool_init(struct vsf_rcbuf_pool_t *pool);
+// allocated buffer has one reference owned by the caller
+struct vsf_rcbuf_t* vsf_rcbuf_alloc(struct vsf_rcbuf_pool_t *pool);
+struct vsf_rcbuf_t* vsf_rcbuf_take(struct vsf_rcbuf_t *rcbuf);
+void vsf_rcbuf_release(struct vsf_rcbuf_t *rcbuf);
+
 // buffer_manager
+// segregated pools of fixed-size blocks serve common sizes in O(1),
+// 		other sizes(or sizes when the pools are exhausted) fall back to a
+// 		first-fit arena with coalescing on free
+// every pointer returned is aligned to VSF_BUFMGR_CFG_ALIGN, set it to the
+// 		DMA(or cache line) alignment required by the hardware
+// bufmgr is NOT reentrant, protect it if used in interrupt
+#ifndef VSF_BUFMGR_CFG_ALIGN
+#define VSF_BUFMGR_CFG_ALIGN			4
+#endif
+#if VSF_BUFMGR_CFG_ALIGN & (VSF_BUFMGR_CFG_ALIGN - 1)
+#error "VSF_BUFMGR_CFG_ALIGN MUST be power of 2"
+#endif
+
+// read only, in_use and peak are in blocks for pool, in bytes for arena
+struct vsf_bufmgr_stat_t
+{
+	uint32_t in_use;
+	uint32_t peak;
+	uint32_t failures;
+};
+
+struct vsf_bufmgr_pool_t
+{
+	struct vsf_buffer_t buffer;
+	uint32_t block_size;
+	
+	struct vsf_bufmgr_stat_t stat;
+	// private
+	void *free_list;
+	uint32_t block_num;
+};
+
 struct vsf_bufmgr_t
 {
+	// memory of the arena, can be {NULL, 0} if only pools are used
 	struct vsf_buffer_t buffer;
-	uint16_t num_of_buffer;
+	// pools MUST be sorted by block_size from small to large
+	struct vsf_bufmgr_pool_t *pool;
+	uint8_t pool_num;
+	
+	struct vsf_bufmgr_stat_t stat;
+	// private
+	void *free_list;
 };
 void vsf_bufmgr_init(struct vsf_bufmgr_t *bufmgr);
 void* vsf_bufmgr_malloc(struct vsf_bufmgr_t *bufmgr, uint32_t size);
@@ -17,45 +17,251 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+#include "app_cfg.h"
 #include "app_type.h"
+#include "interfaces.h"
 
 #include "crc.h"
 
-uint32_t crc_calc(struct crc_t *crc, void *buff, uint32_t num)
+#if CRC_CFG_HW_EN && !IFS_CRC_EN
+#	error "hardware crc depends on IFS_CRC_EN"
+#endif
+
+// register of refin model is reflected and in the lower bits,
+// 		register of other models is left aligned to bit 31,
+// 		so both can be processed byte by byte independent of width
+
+static uint32_t crc_reflect(uint32_t value, uint8_t bitlen)
 {
-	uint8_t bitlen = (uint8_t)crc->bitlen, i;
-	uint32_t result = crc->result;
-	uint8_t *buff8 = (uint8_t *)buff;
-	uint16_t *buff16 = (uint16_t *)buff;
-	uint32_t *buff32 = (uint32_t *)buff;
+	uint32_t result = 0;
+	uint8_t i;
 	
-	while (num--)
+	for (i = 0; i < bitlen; i++)
 	{
-		switch (crc->bitlen)
-		{
-		case CRC_BITLEN_8:
-			result ^= *buff8++;
-			break;
-		case CRC_BITLEN_16:
-			result ^= *buff16++;
-			break;
-		case CRC_BITLEN_32:
-			result ^= *buff32++;
-			break;
-		}
-		for (i = 0; i < bitlen; i++)
+		result = (result << 1) | (value & 1);
+		value >>= 1;
+	}
+	return result;
+}
+
+static uint32_t crc_bitwise(struct crc_model_t *model, uint32_t reg,
+							uint8_t *buff, uint32_t size)
+{
+	uint32_t poly;
+	uint8_t i;
+	
+	if (model->refin)
+	{
+		poly = crc_reflect(model->poly, model->width);
+		while (size--)
 		{
-			if (result & (1UL << (bitlen - 1)))
+			reg ^= *buff++;
+			for (i = 0; i < 8; i++)
 			{
-				result = (result << 1) ^ crc->poly;
+				reg = (reg & 1) ? (reg >> 1) ^ poly : reg >> 1;
 			}
-			else
+		}
+	}
+	else
+	{
+		poly = model->poly << (32 - model->width);
+		while (size--)
+		{
+			reg ^= (uint32_t)*buff++ << 24;
+			for (i = 0; i < 8; i++)
 			{
-				result <<= 1;
+				reg = (reg & 0x80000000) ? (reg << 1) ^ poly : reg << 1;
 			}
 		}
 	}
-	result &= (1ULL << bitlen) - 1;
-	crc->result = result;
+	return reg;
+}
+
+static void crc_gen_table(struct crc_model_t *model)
+{
+	uint32_t *table = model->table, *prev;
+	uint32_t i, j;
+	uint8_t byte;
+	
+	for (i = 0; i < 256; i++)
+	{
+		byte = (uint8_t)i;
+		table[i] = crc_bitwise(model, 0, &byte, 1);
+	}
+	// table[n][i] is table[0][i] followed by n zero bytes
+	for (j = 1; j < model->slice; j++)
+	{
+		prev = table;
+		table += 256;
+		for (i = 0; i < 256; i++)
+		{
+			table[i] = model->refin ?
+				(prev[i] >> 8) ^ model->table[prev[i] & 0xFF] :
+				(prev[i] << 8) ^ model->table[prev[i] >> 24];
+		}
+	}
+	model->table_ready = true;
+}
+
+static uint32_t crc_table_refin(struct crc_model_t *model, uint32_t reg,
+								uint8_t *buff, uint32_t size)
+{
+	uint32_t *t = model->table;
+	uint32_t word;
+	
+	if (8 == model->slice)
+	{
+		for (; size >= 8; size -= 8, buff += 8)
+		{
+			reg ^= GET_LE_U32(buff);
+			word = GET_LE_U32(buff + 4);
+			reg = t[7 * 256 + (reg & 0xFF)] ^
+					t[6 * 256 + ((reg >> 8) & 0xFF)] ^
+					t[5 * 256 + ((reg >> 16) & 0xFF)] ^
+					t[4 * 256 + (reg >> 24)] ^
+					t[3 * 256 + (word & 0xFF)] ^
+					t[2 * 256 + ((word >> 8) & 0xFF)] ^
+					t[1 * 256 + ((word >> 16) & 0xFF)] ^
+					t[word >> 24];
+		}
+	}
+	else if (4 == model->slice)
+	{
+		for (; size >= 4; size -= 4, buff += 4)
+		{
+			reg ^= GET_LE_U32(buff);
+			reg = t[3 * 256 + (reg & 0xFF)] ^
+					t[2 * 256 + ((reg >> 8) & 0xFF)] ^
+					t[1 * 256 + ((reg >> 16) & 0xFF)] ^
+					t[reg >> 24];
+		}
+	}
+	while (size--)
+	{
+		reg = (reg >> 8) ^ t[(reg ^ *buff++) & 0xFF];
+	}
+	return reg;
+}
+
+static uint32_t crc_table_norm(struct crc_model_t *model, uint32_t reg,
+								uint8_t *buff, uint32_t size)
+{
+	uint32_t *t = model->table;
+	uint32_t word;
+	
+	if (8 == model->slice)
+	{
+		for (; size >= 8; size -= 8, buff += 8)
+		{
+			reg ^= GET_BE_U32(buff);
+			word = GET_BE_U32(buff + 4);
+			reg = t[7 * 256 + (reg >> 24)] ^
+					t[6 * 256 + ((reg >> 16) & 0xFF)] ^
+					t[5 * 256 + ((reg >> 8) & 0xFF)] ^
+					t[4 * 256 + (reg & 0xFF)] ^
+					t[3 * 256 + (word >> 24)] ^
+					t[2 * 256 + ((word >> 16) & 0xFF)] ^
+					t[1 * 256 + ((word >> 8) & 0xFF)] ^
+					t[word & 0xFF];
+		}
+	}
+	else if (4 == model->slice)
+	{
+		for (; size >= 4; size -= 4, buff += 4)
+		{
+			reg ^= GET_BE_U32(buff);
+			reg = t[3 * 256 + (reg >> 24)] ^
+					t[2 * 256 + ((reg >> 16) & 0xFF)] ^
+					t[1 * 256 + ((reg >> 8) & 0xFF)] ^
+					t[reg & 0xFF];
+		}
+	}
+	while (size--)
+	{
+		reg = (reg << 8) ^ t[(reg >> 24) ^ *buff++];
+	}
+	return reg;
+}
+
+static uint32_t crc_soft(struct crc_model_t *model, uint32_t reg,
+							uint8_t *buff, uint32_t size)
+{
+	if (NULL == model->table)
+	{
+		return crc_bitwise(model, reg, buff, size);
+	}
+	return model->refin ? crc_table_refin(model, reg, buff, size) :
+							crc_table_norm(model, reg, buff, size);
+}
+
+vsf_err_t crc_init(struct crc_t *crc, struct crc_model_t *model)
+{
+	if ((model->width < 1) || (model->width > 32) ||
+		((model->table != NULL) && (model->slice != 1) &&
+			(model->slice != 4) && (model->slice != 8)))
+	{
+		return VSFERR_INVALID_PARAMETER;
+	}
+	if ((model->table != NULL) && !model->table_ready)
+	{
+		crc_gen_table(model);
+	}
+	
+	crc->model = model;
+	crc->reg = model->refin ? crc_reflect(model->init, model->width) :
+								model->init << (32 - model->width);
+	return VSFERR_NONE;
+}
+
+void crc_update(struct crc_t *crc, uint8_t *buff, uint32_t size)
+{
+	struct crc_model_t *model = crc->model;
+#if CRC_CFG_HW_EN
+	uint32_t head;
+	
+	if ((32 == model->width) && (0x04C11DB7 == model->poly) &&
+		(size >= 8))
+	{
+		head = (4 - ((uint32_t)buff & 3)) & 3;
+		crc->reg = crc_soft(model, crc->reg, buff, head);
+		buff += head;
+		size -= head;
+		
+		crc->reg = core_interfaces.crc.calc(CRC_CFG_HW_INDEX, crc->reg,
+								(uint32_t *)buff, size >> 2, model->refin);
+		buff += size & ~3;
+		size &= 3;
+	}
+#endif
+	crc->reg = crc_soft(model, crc->reg, buff, size);
+}
+
+uint32_t crc_final(struct crc_t *crc)
+{
+	struct crc_model_t *model = crc->model;
+	uint32_t result;
+	
+	result = model->refin ? crc->reg : crc->reg >> (32 - model->width);
+	if (model->refin != model->refout)
+	{
+		result = crc_reflect(result, model->width);
+	}
+	result ^= model->xorout;
+	if (model->width < 32)
+	{
+		result &= (1UL << model->width) - 1;
+	}
 	return result;
 }
+
+uint32_t crc_calc(struct crc_model_t *model, uint8_t *buff, uint32_t size)
+{
+	struct crc_t crc;
+	
+	if (crc_init(&crc, model))
+	{
+		return 0;
+	}
+	crc_update(&crc, buff, size);
+	return crc_final(&crc);
+}
@@ -20,18 +20,77 @@
 #ifndef __CRC_H_INCLUDED__
 #define __CRC_H_INCLUDED__
 
-struct crc_t
+// use hardware CRC unit for CRC-32 and CRC-32/MPEG-2, depends on IFS_CRC_EN
+#ifndef CRC_CFG_HW_EN
+#	define CRC_CFG_HW_EN					0
+#endif
+#ifndef CRC_CFG_HW_INDEX
+#	define CRC_CFG_HW_INDEX					0
+#endif
+
+// Rocksoft model, width is 1 - 32, poly/init/xorout are not reflected
+struct crc_model_t
 {
-	enum crc_bitlen_t
-	{
-		CRC_BITLEN_8 = 8,
-		CRC_BITLEN_16 = 16,
-		CRC_BITLEN_32 = 32,
-	} bitlen;
-	uint32_t result;
+	uint8_t width;
+	bool refin;
+	bool refout;
 	uint32_t poly;
+	uint32_t init;
+	uint32_t xorout;
+	
+	// table of CRC_TABLE_SIZE(slice) entries, generated on first use
+	// table is NULL to calculate bit by bit
+	// slice is 1, 4 or 8, process 1, 4 or 8 bytes per loop
+	uint32_t *table;
+	uint8_t slice;
+	
+	// private
+	volatile bool table_ready;
+};
+
+#define CRC_TABLE_SIZE(slice)				(256 * (slice))
+
+#define CRC_MODEL(width, refin, refout, poly, init, xorout, table, slice)\
+	{(width), (refin), (refout), (poly), (init), (xorout), (table), (slice)}
+
+// check value of "123456789" in comment
+// 0x75, for SD/MMC command
+#define CRC_MODEL_CRC7_MMC(table, slice)		\
+	CRC_MODEL(7, false, false, 0x09, 0x00, 0x00, (table), (slice))
+// 0xF4
+#define CRC_MODEL_CRC8(table, slice)			\
+	CRC_MODEL(8, false, false, 0x07, 0x00, 0x00, (table), (slice))
+// 0x31C3, for SD/MMC data
+#define CRC_MODEL_CRC16_XMODEM(table, slice)	\
+	CRC_MODEL(16, false, false, 0x1021, 0x0000, 0x0000, (table), (slice))
+// 0x29B1
+#define CRC_MODEL_CRC16_CCITT_FALSE(table, slice)\
+	CRC_MODEL(16, false, false, 0x1021, 0xFFFF, 0x0000, (table), (slice))
+// 0x4B37
+#define CRC_MODEL_CRC16_MODBUS(table, slice)	\
+	CRC_MODEL(16, true, true, 0x8005, 0xFFFF, 0x0000, (table), (slice))
+// 0xCBF43926
+#define CRC_MODEL_CRC32(table, slice)			\
+	CRC_MODEL(32, true, true, 0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF, (table),\
+				(slice))
+// 0x0376E6E7, same as hardware CRC unit of STM32
+#define CRC_MODEL_CRC32_MPEG2(table, slice)		\
+	CRC_MODEL(32, false, false, 0x04C11DB7, 0xFFFFFFFF, 0x00000000, (table),\
+				(slice))
+
+struct crc_t
+{
+	struct crc_model_t *model;
+	
+	// private
+	uint32_t reg;
 };
 
-uint32_t crc_calc(struct crc_t *crc, void *buff, uint32_t num);
+vsf_err_t crc_init(struct crc_t *crc, struct crc_model_t *model);
+void crc_update(struct crc_t *crc, uint8_t *buff, uint32_t size);
+uint32_t crc_final(struct crc_t *crc);
+
+// init, update and final in one call
+uint32_t crc_calc(struct crc_model_t *model, uint8_t *buff, uint32_t size);
 
 #endif	// __CRC_H_INCLUDED__
@@ -17,13 +17,16 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+#include "app_cfg.h"
+#include "app_type.h"
+
 #include "list.h"
 
 int sllist_is_in(struct sllist *head, struct sllist *node)
 {
 	while (head != (struct sllist *)0)
 	{
-		if (head->next == node)
+		if (head == node)
 		{
 			return 1;
 		}
@@ -34,24 +37,449 @@ int sllist_is_in(struct sllist *head, struct sllist *node)
 
 int sllist_remove(struct sllist **head, struct sllist *node)
 {
-	if (!sllist_is_in(*head, node))
+	while (*head != (struct sllist *)0)
 	{
-		return -1;
+		if (*head == node)
+		{
+			*head = node->next;
+			node->next = (struct sllist *)0;
+			return 0;
+		}
+		head = &(*head)->next;
 	}
+	return -1;
+}
+
+// heap
+// nodes are numbered from 1 in level order, path to node n is the bits of n
+// 		after the most significant bit, 0 for left and 1 for right
+static struct vsf_heap_node_t **
+vsf_heap_get_link(struct vsf_heap_t *heap, uint32_t n,
+					struct vsf_heap_node_t **parent)
+{
+	struct vsf_heap_node_t **link = &heap->root;
+	uint32_t bit;
 	
-	if (*head == node)
+	for (bit = 1; (bit << 1) && ((bit << 1) <= n); bit <<= 1);
+	*parent = NULL;
+	for (bit >>= 1; bit; bit >>= 1)
 	{
-		head = &node->next;
-		return 0;
+		*parent = *link;
+		link = (n & bit) ? &(*link)->right : &(*link)->left;
 	}
-	while (*head != (struct sllist *)0)
+	return link;
+}
+
+static void vsf_heap_set_link(struct vsf_heap_t *heap,
+			struct vsf_heap_node_t *parent, struct vsf_heap_node_t *old,
+			struct vsf_heap_node_t *node)
+{
+	if (NULL == parent)
+	{
+		heap->root = node;
+	}
+	else if (parent->left == old)
+	{
+		parent->left = node;
+	}
+	else
+	{
+		parent->right = node;
+	}
+}
+
+// exchange node with its parent
+static void vsf_heap_swap(struct vsf_heap_t *heap,
+							struct vsf_heap_node_t *node)
+{
+	struct vsf_heap_node_t *parent = node->parent;
+	struct vsf_heap_node_t *left = node->left, *right = node->right;
+	
+	vsf_heap_set_link(heap, parent->parent, parent, node);
+	node->parent = parent->parent;
+	if (parent->left == node)
+	{
+		node->left = parent;
+		node->right = parent->right;
+		if (node->right != NULL)
+		{
+			node->right->parent = node;
+		}
+	}
+	else
 	{
-		if ((*head)->next == node)
+		node->right = parent;
+		node->left = parent->left;
+		if (node->left != NULL)
+		{
+			node->left->parent = node;
+		}
+	}
+	parent->parent = node;
+	parent->left = left;
+	if (left != NULL)
+	{
+		left->parent = parent;
+	}
+	parent->right = right;
+	if (right != NULL)
+	{
+		right->parent = parent;
+	}
+}
+
+static void vsf_heap_sift(struct vsf_heap_t *heap,
+							struct vsf_heap_node_t *node)
+{
+	struct vsf_heap_node_t *child;
+	
+	while ((node->parent != NULL) && heap->before(node, node->parent))
+	{
+		vsf_heap_swap(heap, node);
+	}
+	while (node->left != NULL)
+	{
+		child = node->left;
+		if ((node->right != NULL) && heap->before(node->right, child))
+		{
+			child = node->right;
+		}
+		if (!heap->before(child, node))
 		{
-			(*head)->next = node->next;
 			break;
 		}
-		*head = (*head)->next;
+		vsf_heap_swap(heap, child);
 	}
-	return 0;
+}
+
+void vsf_heap_init(struct vsf_heap_t *heap)
+{
+	heap->root = NULL;
+	heap->count = 0;
+}
+
+void vsf_heap_insert(struct vsf_heap_t *heap, struct vsf_heap_node_t *node)
+{
+	struct vsf_heap_node_t **link, *parent;
+	
+	link = vsf_heap_get_link(heap, ++heap->count, &parent);
+	*link = node;
+	node->parent = parent;
+	node->left = node->right = NULL;
+	vsf_heap_sift(heap, node);
+}
+
+void vsf_heap_remove(struct vsf_heap_t *heap, struct vsf_heap_node_t *node)
+{
+	struct vsf_heap_node_t **link, *parent, *last;
+	
+	// detach the last node, and put it in the place of node
+	link = vsf_heap_get_link(heap, heap->count--, &parent);
+	last = *link;
+	*link = NULL;
+	if (last != node)
+	{
+		vsf_heap_set_link(heap, node->parent, node, last);
+		last->parent = node->parent;
+		last->left = node->left;
+		if (last->left != NULL)
+		{
+			last->left->parent = last;
+		}
+		last->right = node->right;
+		if (last->right != NULL)
+		{
+			last->right->parent = last;
+		}
+		vsf_heap_sift(heap, last);
+	}
+	node->parent = node->left = node->right = NULL;
+}
+
+// rbtree
+static void vsf_rbtree_set_link(struct vsf_rbtree_t *tree,
+			struct vsf_rbtree_node_t *parent, struct vsf_rbtree_node_t *old,
+			struct vsf_rbtree_node_t *node)
+{
+	if (NULL == parent)
+	{
+		tree->root = node;
+	}
+	else if (parent->left == old)
+	{
+		parent->left = node;
+	}
+	else
+	{
+		parent->right = node;
+	}
+}
+
+static void vsf_rbtree_rotate_left(struct vsf_rbtree_t *tree,
+									struct vsf_rbtree_node_t *node)
+{
+	struct vsf_rbtree_node_t *right = node->right;
+	
+	node->right = right->left;
+	if (node->right != NULL)
+	{
+		node->right->parent = node;
+	}
+	vsf_rbtree_set_link(tree, node->parent, node, right);
+	right->parent = node->parent;
+	right->left = node;
+	node->parent = right;
+}
+
+static void vsf_rbtree_rotate_right(struct vsf_rbtree_t *tree,
+									struct vsf_rbtree_node_t *node)
+{
+	struct vsf_rbtree_node_t *left = node->left;
+	
+	node->left = left->right;
+	if (node->left != NULL)
+	{
+		node->left->parent = node;
+	}
+	vsf_rbtree_set_link(tree, node->parent, node, left);
+	left->parent = node->parent;
+	left->right = node;
+	node->parent = left;
+}
+
+#define vsf_rbtree_is_red(node)			(((node) != NULL) && (node)->red)
+
+void vsf_rbtree_init(struct vsf_rbtree_t *tree)
+{
+	tree->root = NULL;
+}
+
+vsf_err_t vsf_rbtree_insert(struct vsf_rbtree_t *tree,
+						struct vsf_rbtree_node_t *node, const void *key)
+{
+	struct vsf_rbtree_node_t **link = &tree->root, *parent = NULL;
+	struct vsf_rbtree_node_t *gparent, *uncle;
+	int result;
+	
+	while (*link != NULL)
+	{
+		parent = *link;
+		result = tree->compare(parent, key);
+		if (!result)
+		{
+			return VSFERR_FAIL;
+		}
+		link = (result > 0) ? &parent->left : &parent->right;
+	}
+	node->parent = parent;
+	node->left = node->right = NULL;
+	node->red = true;
+	*link = node;
+	
+	while (vsf_rbtree_is_red(node->parent))
+	{
+		parent = node->parent;
+		gparent = parent->parent;
+		uncle = (gparent->left == parent) ? gparent->right : gparent->left;
+		if (vsf_rbtree_is_red(uncle))
+		{
+			parent->red = uncle->red = false;
+			gparent->red = true;
+			node = gparent;
+			continue;
+		}
+		
+		if (gparent->left == parent)
+		{
+			if (parent->right == node)
+			{
+				vsf_rbtree_rotate_left(tree, parent);
+				parent = node;
+			}
+			vsf_rbtree_rotate_right(tree, gparent);
+		}
+		else
+		{
+			if (parent->left == node)
+			{
+				vsf_rbtree_rotate_right(tree, parent);
+				parent = node;
+			}
+			vsf_rbtree_rotate_left(tree, gparent);
+		}
+		parent->red = false;
+		gparent->red = true;
+		break;
+	}
+	tree->root->red = false;
+	return VSFERR_NONE;
+}
+
+void vsf_rbtree_remove(struct vsf_rbtree_t *tree,
+						struct vsf_rbtree_node_t *node)
+{
+	struct vsf_rbtree_node_t *child, *parent, *sibling, *next;
+	bool red;
+	
+	if ((node->left != NULL) && (node->right != NULL))
+	{
+		// replace node with the next node, which has no left child
+		for (next = node->right; next->left != NULL; next = next->left);
+		child = next->right;
+		parent = next->parent;
+		red = next->red;
+		
+		if (parent == node)
+		{
+			parent = next;
+		}
+		else
+		{
+			parent->left = child;
+			if (child != NULL)
+			{
+				child->parent = parent;
+			}
+			next->right = node->right;
+			next->right->parent = next;
+		}
+		vsf_rbtree_set_link(tree, node->parent, node, next);
+		next->parent = node->parent;
+		next->left = node->left;
+		next->left->parent = next;
+		next->red = node->red;
+	}
+	else
+	{
+		child = (node->left != NULL) ? node->left : node->right;
+		parent = node->parent;
+		red = node->red;
+		vsf_rbtree_set_link(tree, parent, node, child);
+		if (child != NULL)
+		{
+			child->parent = parent;
+		}
+	}
+	node->parent = node->left = node->right = NULL;
+	
+	// a black node is removed from the path to child
+	if (red)
+	{
+		return;
+	}
+	while ((child != tree->root) && !vsf_rbtree_is_red(child))
+	{
+		if (parent->left == child)
+		{
+			sibling = parent->right;
+			if (sibling->red)
+			{
+				sibling->red = false;
+				parent->red = true;
+				vsf_rbtree_rotate_left(tree, parent);
+				sibling = parent->right;
+			}
+			if (!vsf_rbtree_is_red(sibling->left) &&
+				!vsf_rbtree_is_red(sibling->right))
+			{
+				sibling->red = true;
+				child = parent;
+				parent = child->parent;
+				continue;
+			}
+			if (!vsf_rbtree_is_red(sibling->right))
+			{
+				sibling->left->red = false;
+				sibling->red = true;
+				vsf_rbtree_rotate_right(tree, sibling);
+				sibling = parent->right;
+			}
+			sibling->red = parent->red;
+			parent->red = false;
+			sibling->right->red = false;
+			vsf_rbtree_rotate_left(tree, parent);
+		}
+		else
+		{
+			sibling = parent->left;
+			if (sibling->red)
+			{
+				sibling->red = false;
+				parent->red = true;
+				vsf_rbtree_rotate_right(tree, parent);
+				sibling = parent->left;
+			}
+			if (!vsf_rbtree_is_red(sibling->left) &&
+				!vsf_rbtree_is_red(sibling->right))
+			{
+				sibling->red = true;
+				child = parent;
+				parent = child->parent;
+				continue;
+			}
+			if (!vsf_rbtree_is_red(sibling->left))
+			{
+				sibling->right->red = false;
+				sibling->red = true;
+				vsf_rbtree_rotate_left(tree, sibling);
+				sibling = parent->left;
+			}
+			sibling->red = parent->red;
+			parent->red = false;
+			sibling->left->red = false;
+			vsf_rbtree_rotate_right(tree, parent);
+		}
+		child = tree->root;
+		break;
+	}
+	if (child != NULL)
+	{
+		child->red = false;
+	}
+}
+
+struct vsf_rbtree_node_t* vsf_rbtree_search(struct vsf_rbtree_t *tree,
+						const void *key)
+{
+	struct vsf_rbtree_node_t *node = tree->root;
+	int result;
+	
+	while (node != NULL)
+	{
+		result = tree->compare(node, key);
+		if (!result)
+		{
+			break;
+		}
+		node = (result > 0) ? node->left : node->right;
+	}
+	return node;
+}
+
+struct vsf_rbtree_node_t* vsf_rbtree_get_first(struct vsf_rbtree_t *tree)
+{
+	struct vsf_rbtree_node_t *node = tree->root;
+	
+	if (node != NULL)
+	{
+		while (node->left != NULL)
+		{
+			node = node->left;
+		}
+	}
+	return node;
+}
+
+struct vsf_rbtree_node_t* vsf_rbtree_get_next(struct vsf_rbtree_node_t *node)
+{
+	if (node->right != NULL)
+	{
+		for (node = node->right; node->left != NULL; node = node->left);
+		return node;
+	}
+	while ((node->parent != NULL) && (node->parent->right == node))
+	{
+		node = node->parent;
+	}
+	return node->parent;
 }
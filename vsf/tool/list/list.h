@@ -20,6 +20,10 @@
 #ifndef __LIST_H_INCLUDED__
 #define __LIST_H_INCLUDED__
 
+// all the containers are intrusive, node is embedded in the user structure,
+// 		and the structure is got by container_of
+// containers cleared to 0 are empty, nodes cleared to 0 are not linked
+
 struct sllist
 {
 	struct sllist *next;
@@ -32,5 +36,164 @@ struct sllist
 int sllist_is_in(struct sllist *head, struct sllist *node);
 int sllist_remove(struct sllist **head, struct sllist *node);
 
-#endif // __LIST_H_INCLUDED__
+// dlist
+// doubly linked list with head and tail, O(1) append and remove
+struct vsf_dlist_node_t
+{
+	struct vsf_dlist_node_t *next;
+	struct vsf_dlist_node_t *prev;
+};
+struct vsf_dlist_t
+{
+	struct vsf_dlist_node_t *head;
+	struct vsf_dlist_node_t *tail;
+};
+
+#define vsf_dlist_init(list)			((list)->head = (list)->tail = NULL)
+#define vsf_dlist_init_node(node)		((node)->next = (node)->prev = NULL)
+#define vsf_dlist_is_empty(list)		(NULL == (list)->head)
+// links of node are cleared when removed, so only the head need to be
+// 		checked for node without previous one
+#define vsf_dlist_is_in(list, node)		\
+	(((node)->prev != NULL) || ((list)->head == (node)))
+#define vsf_dlist_get_container(node, type, member)	\
+	container_of(node, type, member)
+// insert node before pos, append if pos is NULL
+#define vsf_dlist_insert_before(list, pos, node)	\
+	do {\
+		struct vsf_dlist_node_t *__pos = (pos), *__node = (node);\
+		__node->next = __pos;\
+		__node->prev = (NULL == __pos) ? (list)->tail : __pos->prev;\
+		if (NULL == __node->prev)\
+			(list)->head = __node;\
+		else\
+			__node->prev->next = __node;\
+		if (NULL == __pos)\
+			(list)->tail = __node;\
+		else\
+			__pos->prev = __node;\
+	} while (0)
+#define vsf_dlist_append(list, node)	vsf_dlist_insert_before(list, NULL, node)
+#define vsf_dlist_remove(list, node)	\
+	do {\
+		struct vsf_dlist_node_t *__node = (node);\
+		if (NULL == __node->prev)\
+			(list)->head = __node->next;\
+		else\
+			__node->prev->next = __node->next;\
+		if (NULL == __node->next)\
+			(list)->tail = __node->prev;\
+		else\
+			__node->next->prev = __node->prev;\
+		__node->next = __node->prev = NULL;\
+	} while (0)
+
+// hlist
+// doubly linked list with only one pointer as head, used for tables of lists,
+// 		O(1) add to head and remove without the list
+struct vsf_hlist_node_t
+{
+	struct vsf_hlist_node_t *next;
+	struct vsf_hlist_node_t **pprev;
+};
+struct vsf_hlist_t
+{
+	struct vsf_hlist_node_t *head;
+};
+
+#define vsf_hlist_init(list)			((list)->head = NULL)
+#define vsf_hlist_init_node(node)		((node)->next = NULL, (node)->pprev = NULL)
+#define vsf_hlist_is_empty(list)		(NULL == (list)->head)
+#define vsf_hlist_is_linked(node)		((node)->pprev != NULL)
+#define vsf_hlist_get_container(node, type, member)	\
+	container_of(node, type, member)
+#define vsf_hlist_add_head(list, node)	\
+	do {\
+		struct vsf_hlist_node_t *__node = (node);\
+		__node->next = (list)->head;\
+		if (__node->next != NULL)\
+			__node->next->pprev = &__node->next;\
+		__node->pprev = &(list)->head;\
+		(list)->head = __node;\
+	} while (0)
+#define vsf_hlist_remove(node)			\
+	do {\
+		struct vsf_hlist_node_t *__node = (node);\
+		*__node->pprev = __node->next;\
+		if (__node->next != NULL)\
+			__node->next->pprev = __node->pprev;\
+		__node->next = NULL;\
+		__node->pprev = NULL;\
+	} while (0)
+// move all the nodes in from to the empty list to
+#define vsf_hlist_move(from, to)		\
+	do {\
+		(to)->head = (from)->head;\
+		(from)->head = NULL;\
+		if ((to)->head != NULL)\
+			(to)->head->pprev = &(to)->head;\
+	} while (0)
+
+// heap
+// binary min-heap of linked nodes, O(log n) insert and remove of any node
+struct vsf_heap_node_t
+{
+	struct vsf_heap_node_t *parent;
+	struct vsf_heap_node_t *left;
+	struct vsf_heap_node_t *right;
+};
+struct vsf_heap_t
+{
+	// return true if a MUST be before b
+	bool (*before)(struct vsf_heap_node_t *a, struct vsf_heap_node_t *b);
+	
+	// private
+	struct vsf_heap_node_t *root;
+	uint32_t count;
+};
+
+#define vsf_heap_get_first(heap)		((heap)->root)
+#define vsf_heap_is_in(heap, node)		\
+	(((node)->parent != NULL) || ((heap)->root == (node)))
+#define vsf_heap_get_container(node, type, member)	\
+	container_of(node, type, member)
+
+void vsf_heap_init(struct vsf_heap_t *heap);
+void vsf_heap_insert(struct vsf_heap_t *heap, struct vsf_heap_node_t *node);
+void vsf_heap_remove(struct vsf_heap_t *heap, struct vsf_heap_node_t *node);
+
+// rbtree
+// red-black tree, O(log n) insert, remove and search
+struct vsf_rbtree_node_t
+{
+	struct vsf_rbtree_node_t *parent;
+	struct vsf_rbtree_node_t *left;
+	struct vsf_rbtree_node_t *right;
+	bool red;
+};
+struct vsf_rbtree_t
+{
+	// return <0, 0 or >0 if key of node is less than, equal to or
+	// 		greater than key
+	int (*compare)(struct vsf_rbtree_node_t *node, const void *key);
+	
+	// private
+	struct vsf_rbtree_node_t *root;
+};
 
+#define vsf_rbtree_get_container(node, type, member)	\
+	container_of(node, type, member)
+
+void vsf_rbtree_init(struct vsf_rbtree_t *tree);
+// key is the key of node, VSFERR_FAIL if key is already in the tree
+vsf_err_t vsf_rbtree_insert(struct vsf_rbtree_t *tree,
+						struct vsf_rbtree_node_t *node, const void *key);
+void vsf_rbtree_remove(struct vsf_rbtree_t *tree,
+						struct vsf_rbtree_node_t *node);
+struct vsf_rbtree_node_t* vsf_rbtree_search(struct vsf_rbtree_t *tree,
+						const void *key);
+// iterate in the order of the key
+struct vsf_rbtree_node_t* vsf_rbtree_get_first(struct vsf_rbtree_t *tree);
+struct vsf_rbtree_node_t* vsf_rbtree_get_next(struct vsf_rbtree_node_t *node);
+
+#endif // __LIST_H_INCLUDED__